@@ -5,6 +5,11 @@
 /* T */ int Args::timeprecision = 1;
 /* e */ bool Args::errorcheck = 0;
 /* k */ bool Args::skipgraphs = 0;
+/* B */ bool Args::binarygraphs = 0;
+/* z */ bool Args::gzipgraphs = 0;
+/* A */ bool Args::adjacency = 0;
+/* G */ bool Args::graphstats = 0;
+/* I */ bool Args::intonlygraphs = 0;
 /* v */ bool Args::mtvertices = 0;
 /* C */ bool Args::stcsvfiles = 0;
 /* E */ bool Args::edgecounts = 0;
@@ -18,11 +23,17 @@
 /* c */ std::string Args::csvstatfilepath = ".";
 /* g */ std::string Args::graphfilepath = ".";
 /* n */ std::string Args::nmpmergepath = "";
+/* M */ std::string Args::prevgraphpath = "";
 /* p */ std::string Args::splitregionpath = "";
 /* p */ std::string Args::splitregion, Args::splitregionapp;
 /* U */ std::list<std::string> Args::userlist;
 /* L */ int Args::colocationlimit = 0; /* disabled by default */
 /* N */ double Args::nmpthreshold = 0.0005;
+/* D */ std::string Args::dcsnapshot = "";
+/* R */ std::list<std::string> Args::dcrules;
+/* S */ std::list<std::string> Args::scope;
+/* P */ std::string Args::checkpoint = "";
+/* r */ std::string Args::resumefrom = "";
 const char* Args::exec;
 
 bool Args::init(int argc, char *argv[])
@@ -34,6 +45,11 @@ bool Args::init(int argc, char *argv[])
 	#define ARG(N,S,L) ( n+N < argc && (!strcmp(argv[n],S) || !strcmp(argv[n],L)) )
 	{	     if ARG(0, "-e", "--errorcheck")		 errorcheck = 1;
 		else if ARG(0, "-k", "--skipgraphs")		 skipgraphs = 1;
+		else if ARG(0, "-B", "--binary-graphs")		 binarygraphs = 1;
+		else if ARG(0, "-z", "--gzip-graphs")		 gzipgraphs = 1;
+		else if ARG(0, "-A", "--adjacency")		 adjacency = 1;
+		else if ARG(0, "-G", "--graph-stats")		 graphstats = 1;
+		else if ARG(0, "-I", "--intonly-graphs")	 intonlygraphs = 1;
 		else if ARG(0, "-v", "--mt-vertices")		 mtvertices = 1;
 		else if ARG(0, "-C", "--st-csvs")		 stcsvfiles = 1;
 		else if ARG(0, "-E", "--edge-counts")		 edgecounts = 1;
@@ -48,6 +64,10 @@ bool Args::init(int argc, char *argv[])
 		else if ARG(1, "-c", "--csvstatfilepath")	{csvstatfilepath  = argv[++n];}
 		else if ARG(1, "-g", "--graphfilepath")		{graphfilepath    = argv[++n];}
 		else if ARG(1, "-n", "--nmpmergepath")		{nmpmergepath     = argv[++n];}
+		else if ARG(1, "-M", "--prev-graphs")		{prevgraphpath    = argv[++n];}
+		else if ARG(1, "-D", "--datacheck-diff")	{dcsnapshot       = argv[++n];}
+		else if ARG(1, "-P", "--checkpoint")		{checkpoint       = argv[++n];}
+		else if ARG(1, "-r", "--resume-from")		{resumefrom       = argv[++n];}
 		else if ARG(1, "-L", "--colocationlimit")
 		{	colocationlimit = strtol(argv[++n], 0, 10);
 			if (colocationlimit<0) colocationlimit=0;
@@ -70,6 +90,16 @@ bool Args::init(int argc, char *argv[])
 			{	userlist.push_back(argv[n+1]);
 				n++;
 			}
+		else if ARG(1, "-R", "--datacheck-rules")
+			while (n+1 < argc && argv[n+1][0] != '-')
+			{	dcrules.push_back(argv[n+1]);
+				n++;
+			}
+		else if ARG(1, "-S", "--scope")
+			while (n+1 < argc && argv[n+1][0] != '-')
+			{	scope.push_back(argv[n+1]);
+				n++;
+			}
 		else if ARG(3, "-p", "--splitregion")
 		{	splitregionpath = argv[++n];
 			splitregionapp = argv[++n];
@@ -82,6 +112,13 @@ bool Args::init(int argc, char *argv[])
 		}
 	}
 	#undef ARG
+	if (scope.size())
+	{	if (resumefrom.size())
+		{	std::cout << "Fatal error: --scope and --resume-from can't be used together.\n";
+			return 1;
+		}
+		errorcheck = 1;
+	}
 	return 0;
 }
 
@@ -89,11 +126,14 @@ void Args::show_help()
 {	std::string indent(strlen(exec), ' ');
 	std::cout  <<  "usage: " << exec << " [-h] [-w DATAPATH] [-s SYSTEMSFILE]\n";
 	std::cout  <<  indent << "        [-u USERLISTFILEPATH] [-x USERLISTEXT] [-d DATABASENAME] [-l LOGFILEPATH]\n";
-	std::cout  <<  indent << "        [-c CSVSTATFILEPATH] [-g GRAPHFILEPATH] [-k]\n";
+	std::cout  <<  indent << "        [-c CSVSTATFILEPATH] [-g GRAPHFILEPATH] [-k] [-B] [-z] [-A] [-G] [-I]\n";
+	std::cout  <<  indent << "        [-M PREVGRAPHPATH]\n";
 	std::cout  <<  indent << "        [-n NMPMERGEPATH] [-p SPLITREGIONPATH SPLITREGION]\n";
 	std::cout  <<  indent << "        [-U USERLIST [USERLIST ...]] [-t NUMTHREADS] [-e]\n";
 	std::cout  <<  indent << "        [-T TIMEPRECISION] [-v] [-C] [-E] [-b]\n";
-	std::cout  <<  indent << "        [-L COLOCATIONLIMIT] [-N NMPTHRESHOLD]\n";
+	std::cout  <<  indent << "        [-L COLOCATIONLIMIT] [-N NMPTHRESHOLD] [-D DCSNAPSHOT]\n";
+	std::cout  <<  indent << "        [-R RULE [RULE ...]] [-S SCOPE [SCOPE ...]]\n";
+	std::cout  <<  indent << "        [-P CHECKPOINT] [-r RESUMEFROM]\n";
 	std::cout  <<  "\n";
 	std::cout  <<  "Create SQL, stats, graphs, and log files from highway and user data for the\n";
 	std::cout  <<  "Travel Mapping project.\n";
@@ -118,6 +158,24 @@ void Args::show_help()
 	std::cout  <<  "  -g GRAPHFILEPATH, --graphfilepath GRAPHFILEPATH\n";
 	std::cout  <<  "		        Path to write graph format data files\n";
 	std::cout  <<  "  -k, --skipgraphs      Turn off generation of graph files\n";
+	std::cout  <<  "  -B, --binary-graphs   Also write each graph in binary TMG format, as a\n";
+	std::cout  <<  "		        .tmgb file alongside its .tmg file\n";
+	std::cout  <<  "  -z, --gzip-graphs     Compress .tmg files as they're written, as .tmg.gz\n";
+	std::cout  <<  "		        files, listed as such in the graphs DB table\n";
+	std::cout  <<  "  -A, --adjacency       Also write the master graphs' adjacency in binary\n";
+	std::cout  <<  "		        compressed sparse row format, as .csr files\n";
+	std::cout  <<  "  -G, --graph-stats     Write degree, extent & connectivity statistics of\n";
+	std::cout  <<  "		        each graph file to graphstats.csv in GRAPHFILEPATH\n";
+	std::cout  <<  "  -I, --intonly-graphs  Also write an intersection-only version of each\n";
+	std::cout  <<  "		        collapsed graph, with vertices of degree 2 collapsed,\n";
+	std::cout  <<  "		        as a -intonly.tmg file. Not in the graphs DB table\n";
+	std::cout  <<  "  -M PREVGRAPHPATH, --prev-graphs PREVGRAPHPATH\n";
+	std::cout  <<  "		        Graph directory of a previous run. Graph files\n";
+	std::cout  <<  "		        listed in its graphs.manifest are checked against\n";
+	std::cout  <<  "		        the size & hash it records as they're generated;\n";
+	std::cout  <<  "		        those unchanged are hard-linked from there rather\n";
+	std::cout  <<  "		        than rewritten. A new graphs.manifest is written\n";
+	std::cout  <<  "		        to GRAPHFILEPATH\n";
 	std::cout  <<  "  -n NMPMERGEPATH, --nmpmergepath NMPMERGEPATH\n";
 	std::cout  <<  "		        Path to write data with NMPs merged (generated only if\n";
 	std::cout  <<  "		        specified)\n";
@@ -144,4 +202,22 @@ void Args::show_help()
 	std::cout  <<  "		        Threshold to report colocation counts\n";
 	std::cout  <<  "  -N, --nmp-threshold NMPTHRESHOLD\n";
 	std::cout  <<  "		        Threshold to report near-miss points\n";
+	std::cout  <<  "  -D DCSNAPSHOT, --datacheck-diff DCSNAPSHOT\n";
+	std::cout  <<  "		        datacheck.snp from a previous run, to log datacheck\n";
+	std::cout  <<  "		        errors & NMP pairs added, removed or changed since\n";
+	std::cout  <<  "		        then\n";
+	std::cout  <<  "  -R RULE [RULE ...], --datacheck-rules RULE [RULE ...]\n";
+	std::cout  <<  "		        Run only these waypoint datachecks. See\n";
+	std::cout  <<  "		        datacheckrules.log for rule names & timings\n";
+	std::cout  <<  "  -S SCOPE [SCOPE ...], --scope SCOPE [SCOPE ...]\n";
+	std::cout  <<  "		        Errorcheck only these systems and/or the systems\n";
+	std::cout  <<  "		        of these .wpt files, loading nearby routes' systems\n";
+	std::cout  <<  "		        per routebboxes.csv from a previous full run\n";
+	std::cout  <<  "  -P CHECKPOINT, --checkpoint CHECKPOINT\n";
+	std::cout  <<  "		        Write a checkpoint of processed route & traveler\n";
+	std::cout  <<  "		        data to this file, once concurrencies are augmented\n";
+	std::cout  <<  "  -r RESUMEFROM, --resume-from RESUMEFROM\n";
+	std::cout  <<  "		        Resume from a checkpoint written with -P, skipping\n";
+	std::cout  <<  "		        .wpt & .list processing. Requires unchanged .csv\n";
+	std::cout  <<  "		        & .list files\n";
 }
@@ -12,6 +12,12 @@ class Args
 	/* c */ static std::string csvstatfilepath;
 	/* g */ static std::string graphfilepath;
 	/* k */ static bool skipgraphs;
+	/* B */ static bool binarygraphs;
+	/* z */ static bool gzipgraphs;
+	/* A */ static bool adjacency;
+	/* G */ static bool graphstats;
+	/* I */ static bool intonlygraphs;
+	/* M */ static std::string prevgraphpath;
 	/* n */ static std::string nmpmergepath;
 	/* p */ static std::string splitregion, splitregionpath, splitregionapp;
 	/* U */ static std::list<std::string> userlist;
@@ -24,6 +30,11 @@ class Args
 	/* b */ static bool bitsetlogs;
 	/* L */ static int colocationlimit;
 	/* N */ static double nmpthreshold; 
+	/* D */ static std::string dcsnapshot;
+	/* R */ static std::list<std::string> dcrules;
+	/* S */ static std::list<std::string> scope;
+	/* P */ static std::string checkpoint;
+	/* r */ static std::string resumefrom;
 		static const char* exec;
 
 	static bool init(int argc, char *argv[]);
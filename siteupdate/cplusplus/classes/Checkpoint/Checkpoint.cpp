@@ -0,0 +1,437 @@
+#include "Checkpoint.h"
+#include "../Args/Args.h"
+#include "../ConnectedRoute/ConnectedRoute.h"
+#include "../Datacheck/Datacheck.h"
+#include "../DatacheckSnapshot/DatacheckSnapshot.h"
+#include "../HighwaySegment/HighwaySegment.h"
+#include "../HighwaySystem/HighwaySystem.h"
+#include "../Region/Region.h"
+#include "../Route/Route.h"
+#include "../TravelerList/TravelerList.h"
+#include "../Waypoint/Waypoint.h"
+#include "../WaypointQuadtree/WaypointQuadtree.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+static const char magic[] = "TMCHKPNT";
+static const uint32_t version = 2;
+
+// global index of each system's 1st route, and of each route's 1st point & segment
+static std::vector<size_t> route_base, point_base, segment_base;
+
+static size_t route_index(Route* r)
+{	return route_base[r->system - HighwaySystem::syslist.data] + r->index();
+}
+
+static uint32_t region_index(Region* rg)
+{	return rg - Region::allregions.data;
+}
+
+// the .csv, .wpt, .list & .time files read before a checkpoint is written, in a fixed order
+static std::vector<std::string> input_files(std::vector<std::string>& travelers)
+{	std::vector<std::string> files;
+	files.push_back(Args::datapath+"/"+Args::systemsfile);
+	files.push_back(Args::datapath+"/continents.csv");
+	files.push_back(Args::datapath+"/countries.csv");
+	files.push_back(Args::datapath+"/regions.csv");
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	{	files.push_back(Args::datapath+"/data/_systems/"+h.systemname+".csv");
+		files.push_back(Args::datapath+"/data/_systems/"+h.systemname+"_con.csv");
+	}
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (Route& r : h.routes)
+	    files.push_back(Args::datapath+"/data/"+r.rg_str+"/"+h.systemname+"/"+r.root+".wpt");
+	for (std::string& t : travelers)
+	{	std::string travname = t + Args::userlistext;
+		files.push_back(Args::userlistfilepath+"/"+travname);
+		files.push_back(Args::userlistfilepath+"/../time_files/"+&Args::userlistext[1]+'/'+travname+".time");
+	}
+	return files;
+}
+
+// size & modification time, or -1 & 0 for a missing file
+static std::pair<uint64_t, int64_t> fingerprint(std::string& path)
+{	struct stat st;
+	if (stat(path.data(), &st)) return std::make_pair(uint64_t(-1), int64_t(0));
+	return std::make_pair(uint64_t(st.st_size), int64_t(st.st_mtime));
+}
+
+class Writer
+{	std::ofstream file;
+	public:
+	Writer(std::string& filename): file(filename, std::ios::binary) {}
+	bool good() {return file.good();}
+	void close() {file.close();}
+
+	void bytes(const char* c, size_t size)
+	{	file.write(c, size);
+	}
+	template <class T> void put(T v)
+	{	file.write((const char*)&v, sizeof(T));
+	}
+	void str(const std::string& s)
+	{	put<uint32_t>(s.size());
+		file.write(s.data(), s.size());
+	}
+	void regions(std::unordered_map<Region*, double>& m)
+	{	put<uint32_t>(m.size());
+		for (auto& rm : m) put<uint32_t>(region_index(rm.first));
+	}
+};
+
+class Reader
+{	std::string buf;
+	size_t pos;
+	public:
+	bool opened;
+
+	Reader(std::string& filename): pos(0)
+	{	std::ifstream file(filename, std::ios::binary);
+		if ( (opened = file.is_open()) )
+			buf.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	bool done() {return pos == buf.size();}
+
+	// throw if reading past the end of a truncated or corrupt file
+	template <class T> T get()
+	{	T v;
+		if (buf.size() - pos < sizeof(T)) throw 0;
+		memcpy(&v, buf.data()+pos, sizeof(T));
+		pos += sizeof(T);
+		return v;
+	}
+	std::string bytes(size_t size)
+	{	if (buf.size() - pos < size) throw 0;
+		pos += size;
+		return buf.substr(pos-size, size);
+	}
+	std::string str()
+	{	return bytes(get<uint32_t>());
+	}
+	// bounds-checked index into an array of n elements
+	uint32_t index(size_t n)
+	{	uint32_t i = get<uint32_t>();
+		if (i >= n) throw 0;
+		return i;
+	}
+	void regions(std::unordered_map<Region*, double>& m)
+	{	for (uint32_t n = get<uint32_t>(); n; n--)
+			m[Region::allregions.data + index(Region::allregions.size)];
+	}
+};
+
+void Checkpoint::write(std::string filename)
+{	Writer cp(filename);
+	size_t r_idx = 0, p_idx = 0, s_idx = 0;
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	{	route_base.push_back(r_idx);
+		r_idx += h.routes.size;
+		for (Route& r : h.routes)
+		{	point_base.push_back(p_idx);
+			segment_base.push_back(s_idx);
+			p_idx += r.points.size;
+			s_idx += r.segments.size;
+		}
+	}
+	auto point_index = [](Waypoint* w) {return point_base[route_index(w->route)] + (w - w->route->points.data);};
+	auto segment_index = [](HighwaySegment* s) {return segment_base[route_index(s->route)] + (s - s->route->segments.data);};
+
+	cp.bytes(magic, 8);
+	cp.put(version);
+	cp.put<uint32_t>(Region::allregions.size);
+
+	// travelers
+	cp.put<uint32_t>(TravelerList::allusers.size);
+	for (TravelerList& t : TravelerList::allusers) cp.str(t.traveler_name);
+
+	// systems & routes
+	cp.put<uint32_t>(HighwaySystem::syslist.size);
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	{	cp.str(h.systemname);
+		cp.put<uint32_t>(h.routes.size);
+		for (Route& r : h.routes) cp.str(r.root);
+		cp.regions(h.mileage_by_region);
+	}
+
+	// input file fingerprints
+	std::vector<std::string> names;
+	for (TravelerList& t : TravelerList::allusers) names.push_back(t.traveler_name);
+	std::vector<std::string> files = input_files(names);
+	cp.put<uint32_t>(files.size());
+	for (std::string& f : files)
+	{	auto fp = fingerprint(f);
+		cp.put(fp.first);
+		cp.put(fp.second);
+	}
+
+	// waypoints
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (Route& r : h.routes)
+	  {	cp.put<uint8_t>(r.bools);
+		cp.put<uint32_t>(r.points.size);
+		for (Waypoint& w : r.points)
+		{	cp.put(w.lat);
+			cp.put(w.lng);
+			cp.str(w.label);
+			cp.put<uint32_t>(w.alt_labels.size());
+			for (std::string& a : w.alt_labels) cp.str(a);
+		}
+	  }
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (ConnectedRoute& cr : h.con_routes)
+	    cp.put<uint8_t>(cr.disconnected);
+
+	// colocation lists, in the order sorted by WaypointQuadtree::sort
+	uint32_t num_lists = 0;
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (Route& r : h.routes)
+	    for (Waypoint& w : r.points)
+	      if (w.colocated && &w == w.colocated->front()) num_lists++;
+	cp.put(num_lists);
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (Route& r : h.routes)
+	    for (Waypoint& w : r.points)
+	      if (w.colocated && &w == w.colocated->front())
+	      {	cp.put<uint32_t>(w.colocated->size());
+		for (Waypoint* p : *w.colocated) cp.put<uint32_t>(point_index(p));
+	      }
+
+	// concurrencies
+	num_lists = 0;
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (Route& r : h.routes)
+	    for (HighwaySegment& s : r.segments)
+	      if (s.concurrent && &s == s.concurrent->front()) num_lists++;
+	cp.put(num_lists);
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (Route& r : h.routes)
+	    for (HighwaySegment& s : r.segments)
+	      if (s.concurrent && &s == s.concurrent->front())
+	      {	cp.put<uint32_t>(s.concurrent->size());
+		for (HighwaySegment* cs : *s.concurrent) cp.put<uint32_t>(segment_index(cs));
+	      }
+
+	// datacheck errors & NMP pairs
+	cp.put<uint32_t>(Datacheck::errors.size());
+	for (Datacheck& d : Datacheck::errors)
+	{	cp.put<uint32_t>(route_index(d.route));
+		cp.str(d.label1);
+		cp.str(d.label2);
+		cp.str(d.label3);
+		cp.str(d.code);
+		cp.str(d.info);
+	}
+	cp.put<uint32_t>(DatacheckSnapshot::nmp_pairs.size());
+	for (DatacheckSnapshot::Record& rec : DatacheckSnapshot::nmp_pairs)
+	{	cp.put<uint8_t>(rec.flags);
+		cp.str(rec.key);
+		cp.str(rec.value);
+	}
+
+	// traveler data
+	for (TravelerList& t : TravelerList::allusers)
+	{	std::ifstream log(Args::logfilepath+"/users/"+t.traveler_name+".log", std::ios::binary);
+		cp.str(std::string(std::istreambuf_iterator<char>(log), std::istreambuf_iterator<char>()));
+		cp.put<uint32_t>(t.clinched_segments.size());
+		for (HighwaySegment* s : t.clinched_segments) cp.put<uint32_t>(segment_index(s));
+		cp.put<uint32_t>(t.updated_routes.size());
+		for (Route* r : t.updated_routes) cp.put<uint32_t>(route_index(r));
+		cp.regions(t.active_only_mileage_by_region);
+		cp.regions(t.active_preview_mileage_by_region);
+		cp.put<uint32_t>(t.system_region_mileages.size());
+		for (auto& srm : t.system_region_mileages)
+		{	cp.put<uint32_t>(srm.first - HighwaySystem::syslist.data);
+			cp.regions(srm.second);
+		}
+	}
+
+	// travelers of each segment
+	for (HighwaySystem& h : HighwaySystem::syslist)
+	  for (Route& r : h.routes)
+	    for (HighwaySegment& s : r.segments)
+	    {	std::vector<uint32_t> travelers;
+		for (TravelerList* t : s.clinched_by) travelers.push_back(t - TravelerList::allusers.data);
+		cp.put<uint32_t>(travelers.size());
+		for (uint32_t t : travelers) cp.put(t);
+	    }
+
+	if (!cp.good()) std::cout << "WARNING: error writing checkpoint " << filename << std::endl;
+	cp.close();
+	route_base.clear();
+	point_base.clear();
+	segment_base.clear();
+}
+
+bool Checkpoint::read(std::string filename, WaypointQuadtree& all_waypoints)
+{	Reader cp(filename);
+	std::vector<Waypoint*> points;
+	std::vector<HighwaySegment*> segments;
+	// Objects are counted in their arrays' sizes only once constructed,
+	// so that only they are destroyed if aborting partway through.
+	size_t num_travelers = TravelerList::allusers.size;
+	TravelerList::allusers.size = 0;
+	if (!cp.opened)
+	{	std::cout << "Fatal error: could not open checkpoint " << filename << std::endl;
+		return 0;
+	}
+	try {	if (cp.bytes(8) != magic || cp.get<uint32_t>() != version)
+		{	std::cout << "Fatal error: " << filename << " is not a version " << version << " checkpoint file." << std::endl;
+			return 0;
+		}
+		if (cp.get<uint32_t>() != Region::allregions.size)
+		{	std::cout << "Fatal error: regions have changed since checkpoint " << filename << " was written." << std::endl;
+			return 0;
+		}
+
+		// travelers
+		if (cp.get<uint32_t>() != num_travelers)
+		{	std::cout << "Fatal error: traveler list files have changed since checkpoint " << filename << " was written." << std::endl;
+			return 0;
+		}
+		std::vector<std::string> names;
+		for (std::string& id : TravelerList::ids)
+		{	names.emplace_back(cp.str());
+			if (id != names.back() + Args::userlistext)
+			{	std::cout << "Fatal error: traveler " << names.back() << " in checkpoint " << filename << " doesn't match " << id << std::endl;
+				return 0;
+			}
+		}
+		for (std::string& name : names)
+		{	new(TravelerList::allusers.end()) TravelerList(name);
+			// placement new
+			TravelerList::allusers.size++;
+		}
+		TravelerList::tl_it = TravelerList::allusers.end();
+		TravelerList::ids.clear();
+
+		// systems & routes
+		if (cp.get<uint32_t>() != HighwaySystem::syslist.size)
+		{	std::cout << "Fatal error: " << Args::systemsfile << " has changed since checkpoint " << filename << " was written." << std::endl;
+			return 0;
+		}
+		for (HighwaySystem& h : HighwaySystem::syslist)
+		{	if (cp.str() != h.systemname || cp.get<uint32_t>() != h.routes.size)
+			{	std::cout << "Fatal error: system " << h.systemname << " has changed since checkpoint " << filename << " was written." << std::endl;
+				return 0;
+			}
+			for (Route& r : h.routes)
+			  if (cp.str() != r.root)
+			  {	std::cout << "Fatal error: system " << h.systemname << " has changed since checkpoint " << filename << " was written." << std::endl;
+				return 0;
+			  }
+			cp.regions(h.mileage_by_region);
+		}
+
+		// input file fingerprints
+		std::vector<std::string> files = input_files(names);
+		if (cp.get<uint32_t>() != files.size()) throw 0;
+		for (std::string& f : files)
+		{	auto fp = fingerprint(f);
+			uint64_t size = cp.get<uint64_t>();
+			if (cp.get<int64_t>() != fp.second || size != fp.first)
+			{	std::cout << "Fatal error: " << f << " has changed since checkpoint " << filename << " was written." << std::endl;
+				return 0;
+			}
+		}
+
+		std::vector<Route*> routes;
+		for (HighwaySystem& h : HighwaySystem::syslist)
+		  for (Route& r : h.routes) routes.push_back(&r);
+
+		// waypoints & segments
+		for (HighwaySystem& h : HighwaySystem::syslist)
+		  for (Route& r : h.routes)
+		  {	r.bools = cp.get<uint8_t>();
+			uint32_t num_points = cp.get<uint32_t>();
+			r.points.alloc(num_points);
+			r.segments.alloc(num_points ? num_points-1 : 0);
+			r.points.size = r.segments.size = 0;
+			for (uint32_t i = 0; i < num_points; i++)
+			{	double lat = cp.get<double>();
+				double lng = cp.get<double>();
+				std::string label = cp.str();
+				Waypoint* w = new(r.points.end()) Waypoint(&r, lat, lng, label);
+					      // placement new
+				r.points.size++;
+				points.push_back(w);
+				for (uint32_t a = cp.get<uint32_t>(); a; a--) w->alt_labels.emplace_back(cp.str());
+				if (i)
+				{	segments.push_back(new(r.segments.end()) HighwaySegment(w, &r));
+								   // placement new
+					r.segments.size++;
+				}
+			}
+		  }
+		for (HighwaySystem& h : HighwaySystem::syslist)
+		  for (ConnectedRoute& cr : h.con_routes)
+		    cr.disconnected = cp.get<uint8_t>();
+
+		// colocation lists
+		for (uint32_t n = cp.get<uint32_t>(); n; n--)
+		{	auto colocated = new std::list<Waypoint*>;
+					 // deleted by final_report
+			for (uint32_t size = cp.get<uint32_t>(); size; size--)
+			{	Waypoint* w = points[cp.index(points.size())];
+				colocated->push_back(w);
+				w->colocated = colocated;
+			}
+		}
+
+		// concurrencies
+		for (uint32_t n = cp.get<uint32_t>(); n; n--)
+		{	auto concurrent = new std::list<HighwaySegment*>;
+					  // deleted by ~HighwaySegment
+			for (uint32_t size = cp.get<uint32_t>(); size; size--)
+			{	HighwaySegment* s = segments[cp.index(segments.size())];
+				concurrent->push_back(s);
+				s->concurrent = concurrent;
+			}
+		}
+
+		// datacheck errors & NMP pairs
+		for (uint32_t n = cp.get<uint32_t>(); n; n--)
+		{	Route* route = routes[cp.index(routes.size())];
+			std::string l1 = cp.str();
+			std::string l2 = cp.str();
+			std::string l3 = cp.str();
+			std::string code = cp.str();
+			Datacheck::errors.emplace_back(route, l1, l2, l3, code, cp.str());
+		}
+		for (uint32_t n = cp.get<uint32_t>(); n; n--)
+		{	unsigned char flags = cp.get<uint8_t>();
+			std::string key = cp.str();
+			DatacheckSnapshot::nmp_pairs.emplace_back(key, cp.str(), flags);
+		}
+
+		// traveler data
+		for (TravelerList& t : TravelerList::allusers)
+		{	std::ofstream log(Args::logfilepath+"/users/"+t.traveler_name+".log", std::ios::binary);
+			log << cp.str();
+			log.close();
+			t.clinched_segments.resize(cp.get<uint32_t>());
+			for (HighwaySegment*& s : t.clinched_segments) s = segments[cp.index(segments.size())];
+			for (uint32_t n = cp.get<uint32_t>(); n; n--)
+				t.updated_routes.insert(routes[cp.index(routes.size())]);
+			cp.regions(t.active_only_mileage_by_region);
+			cp.regions(t.active_preview_mileage_by_region);
+			for (uint32_t n = cp.get<uint32_t>(); n; n--)
+				cp.regions(t.system_region_mileages[HighwaySystem::syslist.data + cp.index(HighwaySystem::syslist.size)]);
+		}
+
+		// travelers of each segment
+		for (HighwaySegment* s : segments)
+		  for (uint32_t n = cp.get<uint32_t>(); n; n--)
+		    s->clinched_by.add_index(cp.index(TravelerList::allusers.size));
+
+		if (!cp.done()) throw 0;
+	    }
+	catch (const int)
+	    {	std::cout << "Fatal error: checkpoint " << filename << " is truncated or corrupt." << std::endl;
+		return 0;
+	    }
+	// inserted only now, as final_report can't clean up an unsorted quadtree
+	for (Waypoint* w : points) all_waypoints.insert(w, 0);
+	return 1;
+}
@@ -0,0 +1,50 @@
+class WaypointQuadtree;
+#include <string>
+
+class Checkpoint
+{   /* A binary image of the site update's state once traveler lists
+    are processed and augmented for concurrencies, just before stats
+    are computed. Resuming from it skips .wpt & .list processing,
+    NMP & concurrency detection and the logs they produce, and goes
+    straight to stats, datacheck logs, graphs and the .sql file.
+
+    Systems, routes & connected routes are still created from the
+    .csv files, which must be unchanged since the checkpoint was
+    written; the checkpoint stores only their roots, to verify this.
+    The size & mtime of every .csv, .wpt, .list & .time file read are
+    stored too, and resuming fails if any of them differ, so that an
+    input edited since the checkpoint can't go silently ignored.
+    Everything else is stored as array indices rather than pointers,
+    so the file is independent of where it's loaded in memory:
+    waypoints & segments by global position in syslist/routes order,
+    travelers by position in TravelerList::allusers.
+
+    File layout, all integers in native byte order, each string as
+    uint32 length + chars, each list as uint32 count + elements:
+    "TMCHKPNT", uint32 version
+    travelers: list of names
+    systems: list of {name, list of route roots,
+                      list of mileage_by_region region indices}
+    input files: list of {uint64 size, int64 mtime}, in the order
+                 systems file, continents, countries & regions .csv,
+                 each system's .csv & _con.csv, each route's .wpt,
+                 each traveler's .list & .time; size -1 if missing
+    per route: uint8 bools, list of points, each as
+               double lat, double lng, label, list of alt labels
+    per connected route: uint8 disconnected
+    colocation lists: list of lists of waypoint indices
+    concurrencies: list of lists of segment indices
+    datacheck errors: list of {route index, label1, label2, label3,
+                               code, info}
+    NMP pairs for datacheck.snp: list of {uint8 flags, key, value}
+    per traveler: userlog so far, list of clinched segment indices,
+                  list of updated route indices, list of active only
+                  region indices, list of active+preview region indices,
+                  system_region_mileages as list of {system index,
+                  list of region indices}
+    per segment: list of traveler indices, augmented by concurrencies
+    */
+	public:
+	static void write(std::string);
+	static bool read(std::string, WaypointQuadtree&);
+};
@@ -2,17 +2,24 @@
 #include "../Args/Args.h"
 #include "../ElapsedTime/ElapsedTime.h"
 #include "../ErrorList/ErrorList.h"
+#include "../HighwaySystem/HighwaySystem.h"
 #include "../Route/Route.h"
 #include "../../functions/tmstring.h"
 #include <fstream>
+#include <unordered_set>
+#ifdef threading_enabled
+#include <thread>
+#endif
 
 std::mutex Datacheck::mtx;
 std::list<Datacheck> Datacheck::errors;
+thread_local unsigned int Datacheck::adds = 0;
 
 void Datacheck::add(Route *rte, std::string l1, std::string l2, std::string l3, std::string c, std::string i)
 {	mtx.lock();
 	errors.emplace_back(rte, l1, l2, l3, c, i);
 	mtx.unlock();
+	adds++;
 }
 
 Datacheck::Datacheck(Route *rte, std::string l1, std::string l2, std::string l3, std::string c, std::string i)
@@ -25,15 +32,19 @@ Datacheck::Datacheck(Route *rte, std::string l1, std::string l2, std::string l3,
 	fp = 0;
 }
 
-bool Datacheck::match_except_info(std::string* fpentry)
-{	// Check if the fpentry from the csv file matches in all fields
-	// except the info field
-	if (fpentry[0] != route->root)	return 0;
-	if (fpentry[1] != label1)	return 0;
-	if (fpentry[2] != label2)	return 0;
-	if (fpentry[3] != label3)	return 0;
-	if (fpentry[4] != code)		return 0;
-	return 1;
+bool Datacheck::same_key(const Datacheck& other) const
+{	// Check if other matches in all fields except the info field
+	return route == other.route
+	    && label1 == other.label1
+	    && label2 == other.label2
+	    && label3 == other.label3
+	    && code == other.code;
+}
+
+// Key for looking up FP entries matching in all fields except info.
+// FP fields can't contain semicolons, so neither can a key that matches one.
+std::string Datacheck::fp_key() const
+{	return route->root + ";" + label1 + ";" + label2 + ";" + label3 + ";" + code;
 }
 
 // Original "Python list" format unused. Using "CSV style" format instead.
@@ -67,53 +78,97 @@ void Datacheck::read_fps(ErrorList &el)
 		}
 		if (always_error.count(fields[4]))
 			std::cout << "datacheckfps.csv line not allowed (always error): " << line << std::endl;
-		else	fps.push_back(fields);
+		else {	fp_index[fields[0]+';'+fields[1]+';'+fields[2]+';'+fields[3]+';'+fields[4]].push_back(fps.size());
+			fps.push_back(fields);
+		     }
 	}
 	file.close();
 }
 
 void Datacheck::mark_fps(ElapsedTime &et)
 {	errors.sort();
+	// Split sorted errors into one contiguous chunk per thread.
+	// Entries with the same key are adjacent after sorting; keep each
+	// such run within one chunk so that no FP entry is shared between threads.
+	unsigned int const numthreads = Args::numthreads;
+	std::vector<std::list<Datacheck>::iterator> bounds(1, errors.begin());
+	size_t counter = 0;
+	for (auto d = errors.begin(), prev = d; d != errors.end() && bounds.size() < numthreads; prev = d++, counter++)
+	  if (counter >= bounds.size()*errors.size()/numthreads && !d->same_key(*prev))
+	    bounds.push_back(d);
+	bounds.resize(numthreads+1, errors.end());
+
+	std::vector<std::string> nearmatches(numthreads);
+	std::vector<unsigned int> fpcounts(numthreads, 0);
+      #ifdef threading_enabled
+	std::vector<std::thread> thr(numthreads);
+	for (unsigned int t = 0; t < numthreads; t++)
+		thr[t] = std::thread(match_fps, bounds[t], bounds[t+1], &nearmatches[t], &fpcounts[t]);
+	for (unsigned int t = 0; t < numthreads; t++)
+		thr[t].join();
+      #else
+	match_fps(bounds[0], bounds[1], &nearmatches[0], &fpcounts[0]);
+      #endif
+
 	std::ofstream fpfile(Args::logfilepath+"/nearmatchfps.log");
 	time_t timestamp = time(0);
 	fpfile << "Log file created at: " << ctime(&timestamp);
-	unsigned int counter = 0;
 	unsigned int fpcount = 0;
-	for (Datacheck& d : errors)
-	{	//std::cout << "Checking: " << d->str() << std::endl;
-		counter++;
-		if (counter % 1000 == 0) std::cout << '.' << std::flush;
-		for (std::list<std::string*>::iterator fp = fps.begin(); fp != fps.end(); fp++)
-		  if (d.match_except_info(*fp))
-		    if (d.info == (*fp)[5])
-		    {	//std::cout << "Match!" << std::endl;
-			d.fp = 1;
-			fpcount++;
-			delete[] *fp;
-			fps.erase(fp);
-			break;
-		    }
-		    else
-		    {	fpfile << "FP_ENTRY: " << (*fp)[0] << ';' << (*fp)[1] << ';' << (*fp)[2] << ';' << (*fp)[3] << ';' << (*fp)[4] << ';' << (*fp)[5] << '\n';
-			fpfile << "CHANGETO: " << (*fp)[0] << ';' << (*fp)[1] << ';' << (*fp)[2] << ';' << (*fp)[3] << ';' << (*fp)[4] << ';' << d.info << '\n';
-		    }
+	for (unsigned int t = 0; t < numthreads; t++)
+	{	fpfile << nearmatches[t];
+		fpcount += fpcounts[t];
 	}
 	fpfile.close();
 	std::cout << '!' << std::endl;
 	std::cout << et.et() << "Found " << Datacheck::errors.size() << " datacheck errors and matched " << fpcount << " FP entries." << std::endl;
 }
 
+void Datacheck::match_fps(std::list<Datacheck>::iterator d, std::list<Datacheck>::iterator end, std::string* nearmatch, unsigned int* fpcount)
+{	// For each error in [d, end), consume the first unmatched FP entry with
+	// the same key and info, noting near-matches with a different info field
+	// that precede it in datacheckfps.csv.
+	for (unsigned int counter = 1; d != end; ++d, ++counter)
+	{	if (counter % 1000 == 0) std::cout << '.' << std::flush;
+		auto bucket = fp_index.find(d->fp_key());
+		if (bucket == fp_index.end()) continue;
+		for (size_t i : bucket->second)
+		{	std::string* fp = fps[i];
+			if (!fp) continue; // already matched
+			if (d->info == fp[5])
+			{	d->fp = 1;
+				(*fpcount)++;
+				delete[] fp;
+				fps[i] = 0;
+				break;
+			}
+			std::string entry = fp[0] + ';' + fp[1] + ';' + fp[2] + ';' + fp[3] + ';' + fp[4] + ';';
+			nearmatch->append("FP_ENTRY: ").append(entry).append(fp[5]).append(1, '\n');
+			nearmatch->append("CHANGETO: ").append(entry).append(d->info).append(1, '\n');
+		}
+	}
+}
+
 void Datacheck::unmatchedfps_log()
 {	// write log of unmatched false positives from datacheckfps.csv
 	std::ofstream fpfile(Args::logfilepath+"/unmatchedfps.log");
 	time_t timestamp = time(0);
 	fpfile << "Log file created at: " << ctime(&timestamp);
-	if (fps.empty()) fpfile << "No unmatched FP entries.\n";
-	else for (std::string* entry : fps)
-	     {	fpfile << entry[0] << ';' << entry[1] << ';' << entry[2] << ';' << entry[3] << ';' << entry[4] << ';' << entry[5] << '\n';
+	// in a scoped errorcheck, only FPs for routes in scope could have been matched
+	std::unordered_set<std::string> in_scope;
+	if (Args::scope.size()) in_scope = HighwaySystem::roots_in_scope();
+	bool unmatched = 0;
+	for (std::string* entry : fps)
+	  if (entry)
+	  {	if (Args::scope.empty() || in_scope.count(entry[0]))
+		{	fpfile << entry[0] << ';' << entry[1] << ';' << entry[2] << ';' << entry[3] << ';' << entry[4] << ';' << entry[5] << '\n';
+			unmatched = 1;
+		}
 		delete[] entry;
-	     }
+	  }
+	if (!unmatched) fpfile << "No unmatched FP entries.\n";
 	fpfile.close();
+	fps.clear();
+	fp_index.clear();
 }
 
 void Datacheck::datacheck_log()
@@ -133,7 +188,8 @@ bool operator < (const Datacheck &a, const Datacheck &b)
 {	return a.str() < b.str();
 }
 
-std::list<std::string*> Datacheck::fps;
+std::vector<std::string*> Datacheck::fps;
+std::unordered_map<std::string, std::vector<size_t>> Datacheck::fp_index;
 
 std::unordered_set<std::string> Datacheck::always_error
 {	"ABBREV_AS_CHOP_BANNER",
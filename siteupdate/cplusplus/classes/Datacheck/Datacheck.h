@@ -4,7 +4,9 @@ class Route;
 #include <list>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class Datacheck
 {   /* This class encapsulates a datacheck log entry
@@ -63,8 +65,10 @@ class Datacheck
 
     */
 	static std::mutex mtx;
-	static std::list<std::string*> fps;
+	static std::vector<std::string*> fps;	// in datacheckfps.csv order; nulled out when matched
+	static std::unordered_map<std::string, std::vector<size_t>> fp_index; // fps indices by fp_key
 	static std::unordered_set<std::string> always_error;
+	static void match_fps(std::list<Datacheck>::iterator, std::list<Datacheck>::iterator, std::string*, unsigned int*);
 	public:
 	Route *route;
 	std::string label1;
@@ -75,6 +79,7 @@ class Datacheck
 	bool fp;
 
 	static std::list<Datacheck> errors;
+	static thread_local unsigned int adds;	// errors added by this thread, for DatacheckRule hit counts
 	static void add(Route*, std::string, std::string, std::string, std::string, std::string);
 	static void read_fps(ErrorList &);
 	static void mark_fps(ElapsedTime &);
@@ -83,7 +88,8 @@ class Datacheck
 
 	Datacheck(Route*, std::string, std::string, std::string, std::string, std::string);
 
-	bool match_except_info(std::string*);
+	bool same_key(const Datacheck&) const;
+	std::string fp_key() const;
 	std::string str() const;
 };
 
@@ -0,0 +1,170 @@
+#define FMT_HEADER_ONLY
+#include "DatacheckRule.h"
+#include "../Args/Args.h"
+#include "../Datacheck/Datacheck.h"
+#include "../HighwaySegment/HighwaySegment.h"
+#include "../HighwaySystem/HighwaySystem.h"
+#include "../Route/Route.h"
+#include "../Waypoint/Waypoint.h"
+#include <chrono>
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <iterator>
+
+/* single-point checks */
+
+static void out_of_bounds(Route& r)
+{	for (Waypoint& w : r.points) w.out_of_bounds();
+}
+
+static void hidden_terminus(Route& r)
+{	if (!r.points.size) return;
+	if (r.points[0].is_hidden)
+		Datacheck::add(&r, r.points[0].label, "", "", "HIDDEN_TERMINUS", "");
+	if (r.points.size > 1 && r.points.back().is_hidden)
+		Datacheck::add(&r, r.points.back().label, "", "", "HIDDEN_TERMINUS", "");
+}
+
+/* checks for visible points */
+
+#define VISIBLE_LOOP(F) for (Waypoint& w : r.points) if (!w.is_hidden) w.F
+#define USA_LOOP(F) if (r.system->country->first == "USA") \
+			for (Waypoint& w : r.points) if (!w.is_hidden && w.label.size() >= 2) w.F()
+static void bus_with_i(Route& r)		{USA_LOOP(bus_with_i);}
+static void interstate_no_hyphen(Route& r)	{USA_LOOP(interstate_no_hyphen);}
+static void us_letter(Route& r)			{USA_LOOP(us_letter);}
+static void label_invalid_ends(Route& r)	{VISIBLE_LOOP(label_invalid_ends());}
+static void label_looks_hidden(Route& r)	{VISIBLE_LOOP(label_looks_hidden());}
+static void label_lowercase(Route& r)		{VISIBLE_LOOP(label_lowercase());}
+static void label_parens(Route& r)		{VISIBLE_LOOP(label_parens());}
+static void label_slashes(Route& r)		{VISIBLE_LOOP(label_slashes(strchr(w.label.data(), '/')));}
+static void lacks_generic(Route& r)		{VISIBLE_LOOP(lacks_generic());}
+static void underscore_datachecks(Route& r)	{VISIBLE_LOOP(underscore_datachecks(strchr(w.label.data(), '/')));}
+static void label_selfref(Route& r)		{VISIBLE_LOOP(label_selfref());}
+#undef USA_LOOP
+#undef VISIBLE_LOOP
+
+static void visible_distance(Route& r)
+{	if (!r.points.size) return;
+	double vis_dist = 0;
+	Waypoint *last_visible = r.points.data;
+	for (size_t i = 1; i < r.points.size; i++)
+	{	vis_dist += r.segments[i-1].length;
+		if (!r.points[i].is_hidden)
+			r.points[i].visible_distance(vis_dist, last_visible);
+	}
+	// do one last check in case a VISIBLE_DISTANCE error coexists
+	// with a hidden endpoint, as this is only checked for visible points
+	if (r.points.size > 1 && r.points.back().is_hidden)
+		r.points.back().visible_distance(vis_dist, last_visible);
+}
+
+/* checks on segments & angles */
+
+static void long_segment(Route& r)
+{	for (HighwaySegment& s : r.segments)
+	  if (s.length > 20)
+	    Datacheck::add(&r, s.waypoint1->label, s.waypoint2->label, "", "LONG_SEGMENT", fmt::format("{:.2f}", s.length));
+}
+
+static void angles(Route& r)
+{	for (Waypoint* p = r.points.data+1; p < r.points.end()-1; p++)
+	{	if (p[-1].same_coords(p) || p[1].same_coords(p))
+			Datacheck::add(&r, p[-1].label, p->label, p[1].label, "BAD_ANGLE", "");
+		else {	double angle = p->angle();
+			if (angle > 135)
+			  Datacheck::add(&r, p[-1].label, p->label, p[1].label, "SHARP_ANGLE", fmt::format("{:.2f}", angle));
+		     }
+	}
+}
+
+/* colocation-based checks */
+
+static void visible_hidden_coloc(Route& r)
+{	// "visible front" flavored VISIBLE_HIDDEN_COLOC check
+	for (Waypoint& w : r.points)
+	  if (!w.is_hidden && w.colocated && &w == w.colocated->front())
+	    for (auto p = ++w.colocated->begin(), end = w.colocated->end(); p != end; p++)
+	      if ((*p)->is_hidden)
+	      {	Datacheck::add(&r, w.label, "", "", "VISIBLE_HIDDEN_COLOC", (*p)->root_at_label());
+		break;
+	      }
+}
+
+static void hidden_junction(Route& r)
+{	// also handles "hidden front" flavored VISIBLE_HIDDEN_COLOC
+	for (Waypoint& w : r.points)
+	  if (w.is_hidden) w.hidden_junction();
+}
+
+DatacheckRule DatacheckRule::rules[] =
+{	{"out_of_bounds",		wpt,	out_of_bounds,		1},
+	{"long_segment",		wpt,	long_segment,		1},
+	{"hidden_terminus",		wpt,	hidden_terminus,	1},
+	{"bus_with_i",			wpt,	bus_with_i,		1},
+	{"interstate_no_hyphen",	wpt,	interstate_no_hyphen,	1},
+	{"us_letter",			wpt,	us_letter,		1},
+	{"label_invalid_ends",		wpt,	label_invalid_ends,	1},
+	{"label_looks_hidden",		wpt,	label_looks_hidden,	1},
+	{"label_lowercase",		wpt,	label_lowercase,	1},
+	{"label_parens",		wpt,	label_parens,		1},
+	{"label_slashes",		wpt,	label_slashes,		1},
+	{"lacks_generic",		wpt,	lacks_generic,		1},
+	{"underscore_datachecks",	wpt,	underscore_datachecks,	1},
+	{"visible_distance",		wpt,	visible_distance,	1},
+	{"angles",			wpt,	angles,			1},
+	{"label_selfref",		coloc,	label_selfref,		1},
+	{"visible_hidden_coloc",	coloc,	visible_hidden_coloc,	1},
+	{"hidden_junction",		coloc,	hidden_junction,	1}
+};
+
+bool DatacheckRule::select()
+{	// enable only the rules named in Args::dcrules, if any
+	if (Args::dcrules.empty()) return 0;
+	for (DatacheckRule& rule : rules) rule.enabled = 0;
+	for (std::string& name : Args::dcrules)
+	{	DatacheckRule* rule = rules;
+		while (rule < std::end(rules) && name != rule->name) rule++;
+		if (rule == std::end(rules))
+		{	std::cout << "Fatal error: unknown datacheck rule: " << name << "\nAvailable rules:";
+			for (DatacheckRule& r : rules) std::cout << ' ' << r.name;
+			std::cout << std::endl;
+			return 1;
+		}
+		rule->enabled = 1;
+	}
+	return 0;
+}
+
+void DatacheckRule::run(Route& r, Phase phase)
+{	using namespace std::chrono;
+	for (DatacheckRule& rule : rules)
+	  if (rule.phase == phase && rule.enabled)
+	  {	unsigned int adds = Datacheck::adds;
+		steady_clock::time_point start = steady_clock::now();
+		rule.check(r);
+		rule.nanosecs += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+		rule.hits += Datacheck::adds - adds;
+	  }
+}
+
+void DatacheckRule::log()
+{	std::ofstream logfile(Args::logfilepath+"/datacheckrules.log");
+	time_t timestamp = time(0);
+	logfile << "Log file created at: " << ctime(&timestamp);
+	logfile << "Times are summed across all threads. Hits include false positives.\n";
+	logfile << fmt::format("{:<24}{:>6}{:>12}{:>8}\n", "Rule", "Phase", "Seconds", "Hits");
+	double total_time = 0;
+	unsigned int total_hits = 0;
+	for (DatacheckRule& rule : rules)
+	  if (!rule.enabled)
+		logfile << fmt::format("{:<24}{:>6}{:>20}\n", rule.name, rule.phase == wpt ? "wpt" : "coloc", "disabled");
+	  else {double secs = rule.nanosecs / 1e9;
+		logfile << fmt::format("{:<24}{:>6}{:>12.6f}{:>8}\n", rule.name, rule.phase == wpt ? "wpt" : "coloc", secs, rule.hits.load());
+		total_time += secs;
+		total_hits += rule.hits;
+	       }
+	logfile << fmt::format("{:<30}{:>12.6f}{:>8}\n", "Total", total_time, total_hits);
+	logfile.close();
+}
@@ -0,0 +1,28 @@
+class Route;
+#include <atomic>
+
+class DatacheckRule
+{   /* A waypoint datacheck, run as a batch over one route's contiguous
+    points array. Routes are spread across threads by the tasks calling
+    run(): ReadWpt for rules needing only the route's own .wpt data,
+    and RteInt for rules that need colocation lists.
+
+    Time spent and datacheck errors flagged (including FPs) are tallied
+    per rule, and reported in datacheckrules.log.
+    Rules can be selected by name via the -R commandline option.
+    */
+	public:
+	enum Phase {wpt, coloc};
+
+	const char* name;
+	Phase phase;
+	void (*check)(Route&);
+	bool enabled;
+	std::atomic<unsigned long long> nanosecs;
+	std::atomic<unsigned int> hits;
+
+	static DatacheckRule rules[];
+	static bool select();
+	static void run(Route&, Phase);
+	static void log();
+};
@@ -0,0 +1,165 @@
+#include "DatacheckSnapshot.h"
+#include "../Args/Args.h"
+#include "../Datacheck/Datacheck.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+std::vector<DatacheckSnapshot::Record> DatacheckSnapshot::datachecks;
+std::vector<DatacheckSnapshot::Record> DatacheckSnapshot::nmp_pairs;
+static const char magic[] = "TMDCSNAP";
+static const uint32_t version = 1;
+
+DatacheckSnapshot::Record::Record(std::string k, std::string v, unsigned char f): key(k), value(v), flags(f) {}
+
+bool DatacheckSnapshot::Record::operator < (const Record& other) const
+{	int c = key.compare(other.key);
+	if (c) return c < 0;
+	c = value.compare(other.value);
+	if (c) return c < 0;
+	return flags < other.flags;
+}
+
+void DatacheckSnapshot::build()
+{	datachecks.reserve(Datacheck::errors.size());
+	for (Datacheck& d : Datacheck::errors)
+		datachecks.emplace_back(d.fp_key(), d.info, d.fp);
+	std::sort(datachecks.begin(), datachecks.end());
+	std::sort(nmp_pairs.begin(), nmp_pairs.end());
+}
+
+std::string DatacheckSnapshot::str(const Record& r, bool nmp)
+{	if (!nmp) return r.key + ';' + r.value + (r.flags ? " [FP]" : "");
+	std::string s = r.key + ' ' + r.value;
+	if (r.flags)
+	{	s += ' ';
+		if (r.flags & 1) s += "FP";
+		if (r.flags & 2) s += "LI";
+	}
+	return s;
+}
+
+bool DatacheckSnapshot::read(std::string filename, time_t& created, std::vector<Record>& dcs, std::vector<Record>& nmps)
+{	std::ifstream file(filename, std::ios::binary);
+	if (!file) return 0;
+	std::string buf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	size_t pos = 0;
+	auto get = [&](void* dest, size_t size)
+	{	if (buf.size() - pos < size) return false;
+		memcpy(dest, buf.data()+pos, size);
+		pos += size;
+		return true;
+	};
+	char m[8];
+	uint32_t v, num_dcs, num_nmps;
+	int64_t t;
+	if (!get(m, 8) || memcmp(m, magic, 8) || !get(&v, 4) || v != version
+	 || !get(&t, 8) || !get(&num_dcs, 4) || !get(&num_nmps, 4)) return 0;
+	created = t;
+	for (uint32_t i = 0; i < num_dcs + num_nmps; i++)
+	{	unsigned char flags;
+		uint32_t klen, vlen;
+		if (!get(&flags, 1) || !get(&klen, 4) || buf.size() - pos < klen) return 0;
+		size_t k = pos; pos += klen;
+		if (!get(&vlen, 4) || buf.size() - pos < vlen) return 0;
+		size_t val = pos; pos += vlen;
+		(i < num_dcs ? dcs : nmps).emplace_back(buf.substr(k, klen), buf.substr(val, vlen), flags);
+	}
+	return pos == buf.size();
+}
+
+void DatacheckSnapshot::merge_join(std::vector<Record>& was, std::vector<Record>& now, bool nmp, std::string& lines, unsigned int* counts)
+{	// counts = {added, removed, changed}
+	std::vector<Record>::iterator o = was.begin(), n = now.begin();
+	while (o != was.end() || n != now.end())
+	{	if (n == now.end() || o != was.end() && o->key < n->key)
+		{	lines += "REMOVED: " + str(*o++, nmp) + '\n';
+			counts[1]++;
+		}
+		else if (o == was.end() || n->key < o->key)
+		{	lines += "ADDED:   " + str(*n++, nmp) + '\n';
+			counts[0]++;
+		}
+		else {	// a key can repeat with different values; find the end of each run,
+			// skip records that are identical on both sides and pair up the rest
+			std::vector<Record>::iterator oe = o, ne = n;
+			while (oe != was.end() && oe->key == o->key) oe++;
+			while (ne != now.end() && ne->key == n->key) ne++;
+			std::vector<Record*> gone, came;
+			while (o != oe || n != ne)
+				if (n == ne || o != oe && *o < *n)	gone.push_back(&*o++);
+				else if (o == oe || *n < *o)		came.push_back(&*n++);
+				else {	o++; n++;	}
+			size_t i = 0;
+			for (; i < gone.size() && i < came.size(); i++)
+			{	lines += "CHANGED: " + str(*gone[i], nmp) + '\n';
+				lines += "     TO: " + str(*came[i], nmp) + '\n';
+				counts[2]++;
+			}
+			for (size_t j = i; j < gone.size(); j++)
+			{	lines += "REMOVED: " + str(*gone[j], nmp) + '\n';
+				counts[1]++;
+			}
+			for (size_t j = i; j < came.size(); j++)
+			{	lines += "ADDED:   " + str(*came[j], nmp) + '\n';
+				counts[0]++;
+			}
+		     }
+	}
+}
+
+void DatacheckSnapshot::diff(std::string filename)
+{	std::ofstream logfile(Args::logfilepath+"/datacheckdiff.log");
+	time_t timestamp = time(0);
+	logfile << "Log file created at: " << ctime(&timestamp);
+
+	std::vector<Record> prev_dcs, prev_nmps;
+	if (!read(filename, timestamp, prev_dcs, prev_nmps))
+	{	std::cout << "WARNING: could not read datacheck snapshot " << filename << "; no comparison made." << std::endl;
+		logfile << "Could not read datacheck snapshot " << filename << "; no comparison made.\n";
+		return;
+	}
+	logfile << "Changes since datacheck snapshot " << filename << " created at: " << ctime(&timestamp);
+
+	std::string dc_lines, nmp_lines;
+	unsigned int dc_counts[3] = {0,0,0};
+	unsigned int nmp_counts[3] = {0,0,0};
+	merge_join(prev_dcs, datachecks, 0, dc_lines, dc_counts);
+	merge_join(prev_nmps, nmp_pairs, 1, nmp_lines, nmp_counts);
+
+	logfile << "Datacheck errors: " << dc_counts[0] << " added, " << dc_counts[1] << " removed, " << dc_counts[2] << " changed\n";
+	logfile << "Near-miss point pairs: " << nmp_counts[0] << " added, " << nmp_counts[1] << " removed, " << nmp_counts[2] << " changed\n";
+	logfile << "\nDatacheck errors (Root;Waypoint1;Waypoint2;Waypoint3;Error;Info):\n";
+	logfile << (dc_lines.empty() ? "No changes.\n" : dc_lines);
+	logfile << "\nNear-miss point pairs:\n";
+	logfile << (nmp_lines.empty() ? "No changes.\n" : nmp_lines);
+	logfile.close();
+}
+
+void DatacheckSnapshot::write()
+{	std::ofstream file(Args::logfilepath+"/datacheck.snp", std::ios::binary);
+	int64_t t = time(0);
+	uint32_t num_dcs = datachecks.size();
+	uint32_t num_nmps = nmp_pairs.size();
+	file.write(magic, 8);
+	file.write((const char*)&version, 4);
+	file.write((const char*)&t, 8);
+	file.write((const char*)&num_dcs, 4);
+	file.write((const char*)&num_nmps, 4);
+	for (std::vector<Record>* v : {&datachecks, &nmp_pairs})
+	  for (Record& r : *v)
+	  {	uint32_t klen = r.key.size();
+		uint32_t vlen = r.value.size();
+		file.put(r.flags);
+		file.write((const char*)&klen, 4);
+		file.write(r.key.data(), klen);
+		file.write((const char*)&vlen, 4);
+		file.write(r.value.data(), vlen);
+	  }
+	file.close();
+	datachecks.clear();
+	nmp_pairs.clear();
+}
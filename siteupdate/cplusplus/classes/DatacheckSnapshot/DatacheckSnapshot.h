@@ -0,0 +1,46 @@
+#include <ctime>
+#include <string>
+#include <vector>
+
+class DatacheckSnapshot
+{   /* A sorted binary record of a site update's datacheck errors and
+    near-miss point pairs, written to datacheck.snp in the log directory.
+    Merge-joining it against the snapshot of a previous run gives a log
+    of only what was added, removed or changed since then.
+
+    Each record has a key identifying the entry, and a value & flags that
+    can change while the key stays the same:
+
+    record    | key                          | value           | flags
+    ----------+------------------------------+-----------------+---------
+    datacheck | Root;Waypoint1;Waypoint2;    | Info            | 1 = FP
+              | Waypoint3;Error              |                 |
+    NMP pair  | root@label root@label, in    | both points'    | 1 = FP
+              | sort_root_at_label order     | coordinates     | 2 = LI
+
+    File layout, all integers in native byte order:
+    "TMDCSNAP", uint32 version, int64 creation time,
+    uint32 datacheck record count, uint32 NMP record count,
+    then the datacheck records followed by the NMP records, each as
+    uint8 flags, uint32 key length, key, uint32 value length, value.
+    */
+	public:
+	struct Record
+	{	std::string key, value;
+		unsigned char flags;
+
+		Record(std::string, std::string, unsigned char);
+		bool operator < (const Record&) const;
+	};
+
+	static std::vector<Record> nmp_pairs;	// populated by Waypoint::nmplogs
+	static void build();
+	static void diff(std::string);
+	static void write();
+
+	private:
+	static std::vector<Record> datachecks;
+	static bool read(std::string, time_t&, std::vector<Record>&, std::vector<Record>&);
+	static void merge_join(std::vector<Record>&, std::vector<Record>&, bool, std::string&, unsigned int*);
+	static std::string str(const Record&, bool);
+};
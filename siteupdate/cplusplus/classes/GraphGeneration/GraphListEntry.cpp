@@ -1,13 +1,17 @@
 #define FMT_HEADER_ONLY
 #include "GraphListEntry.h"
+#include "HGEdge.h"
 #include "PlaceRadius.h"
+#include "../Args/Args.h"
 #include "../ErrorList/ErrorList.h"
 #include "../HighwaySystem/HighwaySystem.h"
 #include "../Region/Region.h"
+#include <algorithm>
 #include <fmt/format.h>
 
 std::vector<GraphListEntry> GraphListEntry::entries;
-size_t GraphListEntry::num; // iterator for entries
+size_t GraphListEntry::num; // iterator for entries, or tasks if threaded
+std::vector<std::pair<size_t, unsigned char>> GraphListEntry::tasks;
 std::unordered_map<std::string, GraphListEntry*> GraphListEntry::unique_names;
 
 GraphListEntry::GraphListEntry(std::string r, std::string d, char f, char c, std::vector<Region*> *rg, std::vector<HighwaySystem*> *sys, PlaceRadius *pr):
@@ -30,12 +34,27 @@ void GraphListEntry::add_group(std::string&& r, std::string&& d, char c, std::ve
 	}
 }
 
+// mask of HGEdge::format bits for all files written per graph
+unsigned char GraphListEntry::all_formats()
+{	return HGEdge::simple|HGEdge::collapsed|HGEdge::traveled | (Args::intonlygraphs ? HGEdge::intonly : 0);
+}
+
 std::string GraphListEntry::filename()
+{	return stem() + (Args::gzipgraphs ? ".tmg.gz" : ".tmg");
+}
+
+// intersection-only graph derived from a collapsed one
+std::string GraphListEntry::intonly_filename()
+{	return stem() + (Args::gzipgraphs ? "-intonly.tmg.gz" : "-intonly.tmg");
+}
+
+// filename sans extension
+std::string GraphListEntry::stem()
 {	switch (form)
-	{	case 's': return root+"-simple.tmg";
-		case 'c': return root+".tmg";
-		case 't': return root+"-traveled.tmg";
-		default : return std::string("ERROR: GraphListEntry::filename() unexpected format token ('")+form+"')";
+	{	case 's': return root+"-simple";
+		case 'c': return root;
+		case 't': return root+"-traveled";
+		default : return std::string("ERROR: GraphListEntry::stem() unexpected format token ('")+form+"')";
 	}
 }
 
@@ -76,3 +95,49 @@ std::string GraphListEntry::tag()
 		default : return std::string("ERROR: GraphListEntry::tag() unexpected category token ('")+cat+"')";
 	}
 }
+
+/* Order subgraphs for threaded writing, costliest first, so the biggest
+   ones don't start last & leave one thread finishing alone. Cost is
+   estimated as number of simple vertices + edges, from the sets of the
+   regions or systems included, whichever is smaller. Area graphs can't
+   be estimated without searching the quadtree, so they go last, in
+   catalogue order; they're normally small.
+   The master graph, entry 0, is scheduled along with the rest.
+   Any graph costing over a third of a thread's share of the total,
+   normally including the master graph, has its 3 formats scheduled as
+   separate tasks, so different threads can write them. Its
+   intersection-only graph, if any, is a 4th task. */
+void GraphListEntry::schedule(size_t master_cost, unsigned int numthreads)
+{	std::vector<std::pair<size_t, size_t>> costs(1, std::make_pair(master_cost, 0)); // cost & entry index
+	size_t total = master_cost;
+	for (size_t i = 3; i < entries.size(); i += 3)
+	{	GraphListEntry& g = entries[i];
+		size_t cost = 0;
+		if (g.regions)
+		  for (Region* r : *g.regions)
+		    cost += r->vertices.count() + r->edges.count();
+		if (g.systems)
+		{	size_t sys_cost = 0;
+			for (HighwaySystem* h : *g.systems)
+			  sys_cost += h->vertices.count() + h->edges.count();
+			if (!g.regions || sys_cost < cost) cost = sys_cost;
+		}
+		costs.emplace_back(cost, i);
+		total += cost;
+	}
+	std::vector<std::pair<size_t, std::pair<size_t, unsigned char>>> t;
+	for (std::pair<size_t, size_t>& c : costs)
+	  if (c.first*3*numthreads > total)
+	  {	t.emplace_back(c.first/3, std::make_pair(c.second, HGEdge::traveled));
+		t.emplace_back(c.first/3, std::make_pair(c.second, HGEdge::collapsed));
+		t.emplace_back(c.first/3, std::make_pair(c.second, HGEdge::simple));
+		if (Args::intonlygraphs)
+		  t.emplace_back(c.first/3, std::make_pair(c.second, HGEdge::intonly));
+	  }
+	  else	t.emplace_back(c.first, std::make_pair(c.second, all_formats()));
+	std::stable_sort(t.begin(), t.end(),
+		[](const std::pair<size_t, std::pair<size_t, unsigned char>>& a,
+		   const std::pair<size_t, std::pair<size_t, unsigned char>>& b) {return a.first > b.first;});
+	tasks.clear();
+	for (auto& task : t) tasks.push_back(task.second);
+}
@@ -2,8 +2,10 @@ class ErrorList;
 class HighwaySystem;
 class PlaceRadius;
 class Region;
+#include "GraphStats.h"
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 class GraphListEntry
@@ -19,6 +21,8 @@ class GraphListEntry
 
 	// Info for the "graphs" DB table
 	std::string root;	std::string filename();
+				std::string stem();
+				std::string intonly_filename();
 	std::string descr;
 	unsigned int vertices;
 	unsigned int edges;
@@ -26,11 +30,18 @@ class GraphListEntry
 	char form;		std::string format();
 	char cat;		std::string category();
 
+	// Not in the DB; for graphstats.csv, with Args::graphstats
+	GraphStats stats;
+	GraphStats intonly_stats;	// of the intersection-only graph derived from a collapsed one
+
 	static std::vector<GraphListEntry> entries;
-	static size_t num; // iterator for entries
+	static size_t num; // iterator for entries, or tasks if threaded
+	static std::vector<std::pair<size_t, unsigned char>> tasks; // entry index & HGEdge::format mask, costliest first
 	static std::unordered_map<std::string, GraphListEntry*> unique_names;
 
 	GraphListEntry(std::string, std::string, char, char, std::vector<Region*>*, std::vector<HighwaySystem*>*, PlaceRadius*);
 	static void add_group(std::string&&,  std::string&&,  char, std::vector<Region*>*, std::vector<HighwaySystem*>*, PlaceRadius*, ErrorList&);
 	std::string tag();
+	static void schedule(size_t, unsigned int);
+	static unsigned char all_formats();
 };
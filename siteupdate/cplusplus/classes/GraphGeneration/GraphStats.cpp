@@ -0,0 +1,75 @@
+#include "GraphStats.h"
+#include <cmath>
+#include <cstdio>
+
+GraphStats::GraphStats(): num_vertices(0), num_edges(0), max_degree(0), components(0), avg_degree(0), aspect_ratio(1),
+	north(-90), south(90), east(-180), west(180) {}
+
+void GraphStats::vertex(double lat, double lng)
+{	parent.push_back(num_vertices++);
+	degree.push_back(0);
+	if (lat > north) north = lat;
+	if (lat < south) south = lat;
+	if (lng > east)  east  = lng;
+	if (lng < west)  west  = lng;
+}
+
+uint32_t GraphStats::root(uint32_t v)
+{	// path halving
+	while (parent[v] != v)
+		v = parent[v] = parent[parent[v]];
+	return v;
+}
+
+void GraphStats::edge(uint32_t v1, uint32_t v2)
+{	num_edges++;
+	degree[v1]++;
+	degree[v2]++;
+	v1 = root(v1);
+	v2 = root(v2);
+	if (v1 < v2) parent[v2] = v1;
+	else	     parent[v1] = v2;
+}
+
+// great circle distance, the same haversine formula as Waypoint::distance_to
+// sans the CHM fudge factor, which cancels out of the aspect ratio anyway
+static double distance(double lat1, double lng1, double lat2, double lng2)
+{	double const rlat1 = lat1 * (M_PI/180);
+	double const rlng1 = lng1 * (M_PI/180);
+	double const rlat2 = lat2 * (M_PI/180);
+	double const rlng2 = lng2 * (M_PI/180);
+	return asin(sqrt(pow(sin((rlat2-rlat1)/2),2) + cos(rlat1) * cos(rlat2) * pow(sin((rlng2-rlng1)/2),2))) * 7926.2;
+}
+
+void GraphStats::finish()
+{	if (degree.empty())
+	{	north = south = east = west = 0;
+		return;
+	}
+	for (uint32_t v = 0; v < degree.size(); v++)
+	{	if (degree[v] >= histogram.size()) histogram.resize(degree[v]+1, 0);
+		histogram[degree[v]]++;
+		if (parent[v] == v) components++;
+	}
+	max_degree = histogram.size()-1;
+	avg_degree = 2.0*num_edges/degree.size();
+	// width / height, measured across the middle of the bounding box
+	if (east != west && north != south)
+	{	double const mid_lat = (north+south)/2;
+		double const mid_lng = (east+west)/2;
+		aspect_ratio = distance(mid_lat, west, mid_lat, east) / distance(north, mid_lng, south, mid_lng);
+	}
+	std::vector<uint32_t>().swap(degree);
+	std::vector<uint32_t>().swap(parent);
+}
+
+void GraphStats::write_csv(std::ofstream& csv) const
+{	char buf[128];
+	snprintf(buf, sizeof(buf), "%u;%.4f;%.6f;%u;%.6f;%.6f;%.6f;%.6f;",
+		 max_degree, avg_degree, aspect_ratio, components, north, south, east, west);
+	csv << buf;
+	for (size_t d = 0; d < histogram.size(); d++)
+	{	if (d) csv << ' ';
+		csv << histogram[d];
+	}
+}
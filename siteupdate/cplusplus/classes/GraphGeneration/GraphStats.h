@@ -0,0 +1,30 @@
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+class GraphStats
+{   /* Vertex degree, extent & connectivity statistics of one graph file,
+    gathered while it's written, as ArchiveGraphs would otherwise compute
+    them by reading it back in. Vertices are added in file order, then
+    edges by vertex number; degrees & a union-find forest are kept until
+    finish() tallies them up.
+    */
+	std::vector<uint32_t> degree;
+	std::vector<uint32_t> parent;
+
+	uint32_t root(uint32_t);
+
+	public:
+	uint32_t num_vertices, num_edges;
+	uint32_t max_degree, components;
+	double avg_degree, aspect_ratio;
+	double north, south, east, west;	// extreme latitudes & longitudes
+	std::vector<uint32_t> histogram;	// number of vertices of each degree
+
+	GraphStats();
+
+	void vertex(double lat, double lng);
+	void edge(uint32_t v1, uint32_t v2);
+	void finish();
+	void write_csv(std::ofstream&) const;
+};
@@ -0,0 +1,82 @@
+#include "HGCSR.h"
+#include "HGEdge.h"
+#include "HGVertex.h"
+#include <fstream>
+
+static size_t pad8(size_t n) {return (n+7) & ~size_t(7);}
+
+void HGCSR::build(std::vector<HGVertex>& v_array, TMArray<HGEdge>& e_array, unsigned char fmt)
+{	clear();
+	format = fmt;
+	// number vertices as write_master_graphs_tmg does
+	char const min_vis = fmt == HGEdge::simple ? 0 : fmt == HGEdge::collapsed ? 2 : 1;
+	std::vector<uint32_t> vnum(v_array.size());
+	for (HGVertex& v : v_array)
+	  if (v.visibility >= min_vis)
+	  {	vnum[&v-v_array.data()] = vertices.size();
+		vertices.push_back(&v);
+	  }
+
+	// number edges, count degrees & store endpoints & weights
+	offsets.assign(vertices.size()+1, 0);
+	for (HGEdge& e : e_array)
+	  if (e.format & fmt)
+	  {	uint32_t const v1 = vnum[e.vertex1-v_array.data()];
+		uint32_t const v2 = vnum[e.vertex2-v_array.data()];
+		edges.push_back(&e);
+		ends.push_back(v1);
+		ends.push_back(v2);
+		weights.push_back(e.length());
+		offsets[v1+1]++;
+		offsets[v2+1]++;
+	  }
+
+	// convert degrees to offsets & fill in adjacencies
+	for (size_t v = 1; v < offsets.size(); v++) offsets[v] += offsets[v-1];
+	adj.resize(offsets.back());
+	adj_edges.resize(offsets.back());
+	std::vector<uint32_t> pos(offsets.begin(), offsets.end()-1);
+	for (uint32_t e = 0; e < edges.size(); e++)
+	{	uint32_t const v1 = ends[2*e];
+		uint32_t const v2 = ends[2*e+1];
+		adj[pos[v1]] = v2; adj_edges[pos[v1]++] = e;
+		adj[pos[v2]] = v1; adj_edges[pos[v2]++] = e;
+	}
+}
+
+bool HGCSR::write(const std::string& filename) const
+{	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) return 0;
+	const char zeros[8] = {};
+	auto section = [&](const void* data, size_t bytes)
+	{	file.write((const char*)data, bytes);
+		file.write(zeros, pad8(bytes)-bytes);
+	};
+	uint32_t const header[5] = {1, uint32_t(format == HGEdge::simple ? 0 : format == HGEdge::collapsed ? 1 : 2),
+				    num_vertices(), num_edges(), uint32_t(adj.size())};
+	file.write("TMCS", 4);
+	file.write((const char*)header, sizeof(header)); // 24 bytes in all
+	section(offsets.data(),   offsets.size()   * 4);
+	section(adj.data(),	  adj.size()       * 4);
+	section(adj_edges.data(), adj_edges.size() * 4);
+	section(ends.data(),      ends.size()      * 4);
+	section(weights.data(),   weights.size()   * sizeof(double));
+	std::vector<double> coords;
+	coords.reserve(2*vertices.size());
+	for (HGVertex* v : vertices)
+	{	coords.push_back(v->lat);
+		coords.push_back(v->lng);
+	}
+	section(coords.data(),    coords.size()    * sizeof(double));
+	return file.good();
+}
+
+void HGCSR::clear()
+{	std::vector<uint32_t>().swap(offsets);
+	std::vector<uint32_t>().swap(adj);
+	std::vector<uint32_t>().swap(adj_edges);
+	std::vector<uint32_t>().swap(ends);
+	std::vector<double>().swap(weights);
+	std::vector<HGVertex*>().swap(vertices);
+	std::vector<HGEdge*>().swap(edges);
+}
@@ -0,0 +1,49 @@
+class HGEdge;
+class HGVertex;
+#include "../../templates/TMArray.cpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class HGCSR
+{   /* Compressed sparse row adjacency of one format of the master graph,
+    for connectivity, shortest path & other graph algorithms.
+    Vertices & edges are numbered as in that format's master .tmg file.
+    Each edge is listed in the adjacency of both its endpoints; a loop,
+    twice in that of its one vertex. Edge weights are lengths in miles,
+    the total length of the segments the edge spans.
+
+    write() dumps it to a binary file, little-endian, each section
+    beginning at a multiple of 8 bytes:
+      header	  char magic[4] "TMCS", then uint32_t version (1),
+		  format (0 simple, 1 collapsed, 2 traveled, as in .tmgb files),
+		  num_vertices, num_edges, & num_adj (2 x num_edges)
+      offsets	  num_vertices+1 x uint32_t
+      adj	  num_adj x uint32_t neighboring vertex numbers
+      adj_edges	  num_adj x uint32_t edge numbers, parallel to adj
+      ends	  num_edges x 2 uint32_t endpoint vertex numbers
+      weights	  num_edges x double
+      coords	  num_vertices x 2 double latitude & longitude
+    */
+	public:
+	std::vector<uint32_t>  offsets;		// vertex v's adjacency is [offsets[v], offsets[v+1])
+	std::vector<uint32_t>  adj;		// neighboring vertex numbers
+	std::vector<uint32_t>  adj_edges;	// numbers of the edges leading to them
+	std::vector<uint32_t>  ends;		// endpoint vertex numbers, 2 per edge
+	std::vector<double>    weights;		// edge lengths, by edge number
+	std::vector<HGVertex*> vertices;	// by vertex number
+	std::vector<HGEdge*>   edges;		// by edge number
+	unsigned char format;			// HGEdge::format bit
+
+	HGCSR(): format(0) {}
+
+	void build(std::vector<HGVertex>&, TMArray<HGEdge>&, unsigned char);
+	bool write(const std::string&) const;
+	void clear();
+
+	uint32_t num_vertices() const {return vertices.size();}
+	uint32_t num_edges()    const {return edges.size();}
+	uint32_t degree(uint32_t v) const {return offsets[v+1]-offsets[v];}
+	const uint32_t* adj_begin(uint32_t v) const {return adj.data()+offsets[v];}
+	const uint32_t* adj_end  (uint32_t v) const {return adj.data()+offsets[v+1];}
+};
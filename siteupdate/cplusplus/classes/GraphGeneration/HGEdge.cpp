@@ -10,13 +10,18 @@
 #include <fmt/format.h>
 
 HGVertex* HGEdge::v_array;
+std::vector<HGVertex*> HGEdge::ip_arena;
+std::vector<std::string> HGEdge::names;
 
-HGEdge::HGEdge(HighwaySegment *s)
-{	// initial construction is based on a HighwaySegment
+HGEdge::HGEdge(HighwaySegment *s, uint32_t name)
+{	// initial construction is based on a HighwaySegment,
+	// its name already interned in names by the graph ctor
 	vertex1 = s->waypoint1->hashpoint()->vertex;
 	vertex2 = s->waypoint2->hashpoint()->vertex;
 	format = simple | collapsed | traveled;
-	segment_name = s->segment_name();
+	name_id = name;
+	hops[0] = hops[1] = this;
+	ip_idx = ip_num = 0;
 	vertex1->incident_edges.push_back(this);
 	vertex2->incident_edges.push_back(this);
 	vertex1->edge_count++;
@@ -32,56 +37,51 @@ HGEdge::HGEdge(HGVertex *vertex, unsigned char fmt_mask, HGEdge *edge1, HGEdge *
 {	// build by collapsing two existing edges around a common hidden vertex
 	c_idx = vertex - v_array;
 	format = fmt_mask;
-	segment_name = edge1->segment_name;
+	name_id = edge1->name_id;
 	/*std::cout << "\nDEBUG: collapsing edges |";
 	if (fmt_mask & collapsed) std::cout << 'c';	else std::cout << '-';
 	if (fmt_mask & traveled)  std::cout << 't';	else std::cout << '-';
-	std::cout << "| along " << segment_name << " at vertex " << *(vertex->unique_name);
+	std::cout << "| along " << segment_name() << " at vertex " << vertex->unique_name;
 	std::cout << "\n       edge1 is " << edge1->str();
 	std::cout << "\n       edge2 is " << edge2->str() << std::endl;//*/
 	segment = edge1->segment;
 
 	// figure out and remember which endpoints are not the
 	// vertex we are collapsing and set them as our new
-	// endpoints, and at the same time, build up our list of
-	// intermediate vertices
-	intermediate_points = edge1->intermediate_points;
-	//std::cout << "DEBUG: copied edge1 intermediates" << intermediate_point_string() << std::endl;
+	// endpoints, and at the same time, which simple edges
+	// lead from them toward the vertex. Intermediate points
+	// themselves are gathered by get_intermediates once
+	// compression is complete; for now, just count them.
+	ip_num = edge1->ip_num + 1 + edge2->ip_num;
 
 	if (edge1->vertex1 == vertex)
-	     {	//std::cout << "DEBUG: vertex1 getting edge1->vertex2: " << *(edge1->vertex2->unique_name) << " and reversing edge1 intermediates" << std::endl;
-		vertex1 = edge1->vertex2;
-		intermediate_points.reverse();
+	     {	vertex1 = edge1->vertex2;
+		hops[0] = edge1->hops[1];
 	     }
-	else {	//std::cout << "DEBUG: vertex1 getting edge1->vertex1: " << *(edge1->vertex1->unique_name) << std::endl;
-		vertex1 = edge1->vertex1;
+	else {	vertex1 = edge1->vertex1;
+		hops[0] = edge1->hops[0];
 	     }
 
-	//std::cout << "DEBUG: appending to intermediates: " << *(vertex->unique_name) << std::endl;
-	intermediate_points.push_back(vertex);
-
 	if (edge2->vertex1 == vertex)
-	     {	//std::cout << "DEBUG: vertex2 getting edge2->vertex2: " << *(edge2->vertex2->unique_name) << std::endl;
-		vertex2 = edge2->vertex2;
-		intermediate_points.insert(intermediate_points.end(), edge2->intermediate_points.begin(), edge2->intermediate_points.end());
+	     {	vertex2 = edge2->vertex2;
+		hops[1] = edge2->hops[1];
 	     }
-	else {	//std::cout << "DEBUG: vertex2 getting edge2->vertex1: " << *(edge2->vertex1->unique_name) << " and reversing edge2 intermediates" << std::endl;
-		vertex2 = edge2->vertex1;
-		intermediate_points.insert(intermediate_points.end(), edge2->intermediate_points.rbegin(), edge2->intermediate_points.rend());
+	else {	vertex2 = edge2->vertex1;
+		hops[1] = edge2->hops[0];
 	     }
-
-	//std::cout << "DEBUG: intermediates complete: from " << *(vertex1->unique_name) << " via " << \
-			intermediate_point_string() << " to " << *(vertex2->unique_name) << std::endl;
 	//std::cout << "DEBUG: new " << str() << std::endl;
 
 	// clear format bits of old edges
 	edge1->format &= ~fmt_mask;
 	edge2->format &= ~fmt_mask;
-	// replace edge references at our endpoints with ourself
-	if (!edge1->format) edge1->detach();
-	if (!edge2->format) edge2->detach();
-	vertex1->incident_edges.push_back(this);
-	vertex2->incident_edges.push_back(this);
+	// replace edge references at our endpoints with ourself,
+	// and release what we can of edges no longer in any graph
+	if (!edge1->format) edge1->release();
+	if (!edge2->format) edge2->release();
+	// Visible vertices can end multiple chains compressed concurrently;
+	// HighwayGraph's ctor updates their edge lists afterward.
+	if (vertex1->visibility < 2) vertex1->incident_edges.push_back(this);
+	if (vertex2->visibility < 2) vertex2->incident_edges.push_back(this);
 }
 
 void HGEdge::detach()
@@ -93,18 +93,58 @@ void HGEdge::detach()
 		break; \
 	    }
 	};
-	detach(vertex1->incident_edges);
-	detach(vertex2->incident_edges);
+	if (vertex1->visibility < 2) detach(vertex1->incident_edges);
+	if (vertex2->visibility < 2) detach(vertex2->incident_edges);
+}
+
+void HGEdge::release()
+{	detach();
+	ip_idx = ip_num = 0;
+}
+
+void HGEdge::get_intermediates(HGVertex** ip)
+{	// walk the chain of hidden vertices from vertex1 to vertex2
+	// along simple edges, which are never detached. Each hidden
+	// vertex has exactly 2; leave it by the one we didn't arrive on.
+	HGVertex* v = vertex1;
+	HGEdge* e = hops[0];
+	ip_idx = ip - ip_arena.data();
+	for (HGVertex** end = ip+ip_num; ip < end; ++ip)
+	{	*ip = v = e->vertex1 == v ? e->vertex2 : e->vertex1;
+		for (HGEdge* i : v->incident_edges)
+		  if (i->format & simple && i != e)
+		  {	e = i;
+			break;
+		  }
+	}
+}
+
+double HGEdge::length()
+{	// total length of the simple edges along the chain, walked as in get_intermediates
+	HGVertex* v = vertex1;
+	HGEdge* e = hops[0];
+	double len = e->segment->length;
+	for (uint32_t n = 0; n < ip_num; n++)
+	{	v = e->vertex1 == v ? e->vertex2 : e->vertex1;
+		for (HGEdge* i : v->incident_edges)
+		  if (i->format & simple && i != e)
+		  {	e = i;
+			break;
+		  }
+		len += e->segment->length;
+	}
+	return len;
 }
 
 /* line appropriate for a tmg collapsed edge file, with debug info
 std::string HGEdge::debug_tmg_line(std::vector<HighwaySystem*> *systems, unsigned int threadnum)
-{	std::string line = std::to_string(vertex1->c_vertex_num[threadnum]) + " [" + *vertex1->unique_name + "] " \
-			 + std::to_string(vertex2->c_vertex_num[threadnum]) + " [" + *vertex2->unique_name + "] " + label(systems);
+{	std::string line = std::to_string(vertex1->c_vertex_num[threadnum]) + " [" + vertex1->unique_name + "] " \
+			 + std::to_string(vertex2->c_vertex_num[threadnum]) + " [" + vertex2->unique_name + "] " + label(systems);
 	char fstr[58];
-	for (HGVertex *intermediate : intermediate_points)
-	{	*fmt::format_to(fstr, "] {:.15} {:.15}", intermediate->lat, intermediate->lng) = 0;
-		line += " [" + *intermediate->unique_name + fstr;
+	for (HGVertex **ip = ip_begin(), **end = ip_end(); ip != end; ++ip)
+	{	HGVertex *intermediate = *ip;
+		*fmt::format_to(fstr, "] {:.15} {:.15}", intermediate->lat, intermediate->lng) = 0;
+		line.append(" [").append(intermediate->unique_name).append(fstr);
 	}
 	return line;
 }*/
@@ -115,22 +155,23 @@ std::string HGEdge::str()
 	if (format & simple)	str += 's';	else str += '-';
 	if (format & collapsed)	str += 'c';	else str += '-';
 	if (format & traveled)	str += 't';	else str += '-';
-	str += "|: " + segment_name
-	+ " from " + *vertex1->unique_name
-	+  " to "  + *vertex2->unique_name
-	+  " via " + std::to_string(intermediate_points.size()) + " points {"
+	str += "|: " + segment_name()
+	+ " from " + vertex1->unique_name
+	+  " to "  + vertex2->unique_name
+	+  " via " + std::to_string(ip_num) + " points {"
 	+ std::to_string((long long unsigned int)this) + '}';
 	return str;
 }
 
 // return the intermediate points as a string
 std::string HGEdge::intermediate_point_string()
-{	if (intermediate_points.empty()) return " None";
+{	if (!ip_num) return " None";
 	std::string line = "";
 	char fstr[56];
-	for (HGVertex *i : intermediate_points)
-	{	*fmt::format_to(fstr, "{:.15} {:.15}", i->lat, i->lng) = 0;
-		line += " [" + *i->unique_name + "] " + fstr;
+	for (HGVertex **ip = ip_begin(), **end = ip_end(); ip != end; ++ip)
+	{	HGVertex *i = *ip;
+		*fmt::format_to(fstr, "{:.15} {:.15}", i->lat, i->lng) = 0;
+		line.append(" [").append(i->unique_name).append("] ").append(fstr);
 	}
 	return line;
 }
@@ -1,8 +1,9 @@
 class HGVertex;
 class HighwaySegment;
 class HighwaySystem;
+#include <cstdint>
 #include <iostream>
-#include <list>
+#include <string>
 #include <vector>
 
 class HGEdge
@@ -10,27 +11,39 @@ class HGEdge
     edge that can incorporate intermediate points.
     */
 	public:
-	std::string segment_name;
 	HGVertex *vertex1, *vertex2;
-	std::list<HGVertex*> intermediate_points; // if more than 1, will go from vertex1 to vertex2
+	HGEdge *hops[2];	// simple edges at vertex1 & vertex2 ends; chain is walked from hops[0]
 	HighwaySegment *segment;
+	uint32_t ip_idx, ip_num; // range of intermediate points in ip_arena, from vertex1 to vertex2
 	uint32_t c_idx; // index of last vertex collapsed, if applicable
 			// no "real" use, only for diagnostics & logging
+	uint32_t name_id; // index of segment name in names
 	unsigned char format;
 
 	// constants for more human-readable format masks
 	static constexpr unsigned char simple = 1;
 	static constexpr unsigned char collapsed = 2;
 	static constexpr unsigned char traveled = 4;
+	// not an edge format, but a file format for write_subgraphs_tmg:
+	// intersection-only graphs are derived from each graph's collapsed edges
+	static constexpr unsigned char intonly = 8;
 
 	// this avoids adding more arguments to the collapse ctor
 	// and adding more ugly code to the collapse routine in the graph ctor
 	static HGVertex* v_array;	// for calculating c_idx
+	static std::vector<HGVertex*> ip_arena; // intermediate points of all live collapsed & traveled edges
+	static std::vector<std::string> names;	// distinct segment names, shared by all edges along them
 
-	HGEdge(HighwaySegment *);
+	HGEdge(HighwaySegment *, uint32_t);
 	HGEdge(HGVertex *, unsigned char, HGEdge*, HGEdge*);
 
 	void detach();
+	void release();
+	void get_intermediates(HGVertex**);
+	double length();
+	const std::string& segment_name() const {return names[name_id];}
+	HGVertex** ip_begin() {return ip_arena.data()+ip_idx;}
+	HGVertex** ip_end()   {return ip_arena.data()+ip_idx+ip_num;}
 	std::string debug_tmg_line(std::vector<HighwaySystem*> *, unsigned int);
 	std::string str();
 	std::string intermediate_point_string();
@@ -7,12 +7,14 @@
 #include "../Region/Region.h"
 #include "../Route/Route.h"
 #include "../Waypoint/Waypoint.h"
+#include <cmath>
+#include <cstring>
 #include <fmt/format.h>
 
 std::atomic_uint HGVertex::num_hidden(0);
-thread_local int* HGVertex::vnums;
+std::vector<char> HGVertex::coord_pool;
 
-void HGVertex::setup(Waypoint *wpt, const std::string *n)
+void HGVertex::setup(Waypoint *wpt, const char *n)
 {	lat = wpt->lat;
 	lng = wpt->lng;
 	wpt->vertex = this;
@@ -59,11 +61,67 @@ HGEdge* HGVertex::back(unsigned char format)
 	throw this;
 }
 
-void HGVertex::format_coordstr()
+// Write d as fmt's "{:.15}" would. Nearly all coordinates are exact to 6
+// decimal places, & for these, that's the 6-place decimal with trailing
+// zeros trimmed: it's the decimal nearest d, & with <= 15 significant
+// digits, rounding d to 15 digits yields it back. Write those directly;
+// leave anything else, & anything %g would put in exponent notation, to fmt.
+static char* format_coord(char* s, double d)
+{	double const a = fabs(d);
+	if (a >= 1e-4 && a < 1e9)
+	{	long long const r = llround(a*1e6);
+		if (r / 1e6 == a)
+		{	if (d < 0) *s++ = '-';
+			char digits[10];
+			char* i = digits+10;
+			long long n = r / 1000000;
+			do {	*--i = '0' + n%10;
+				n /= 10;
+			   } while (n);
+			memcpy(s, i, digits+10-i);
+			s += digits+10-i;
+			unsigned int f = r % 1000000;
+			if (f)
+			{	*s = '.';
+				for (char* p = s+6; p > s; f /= 10) *p-- = '0' + f%10;
+				s += 7;
+				while (s[-1] == '0') s--;
+			}
+			return s;
+		}
+	}
+	return fmt::format_to(s, "{:.15}", d);
+}
+
+void HGVertex::format_coordstr(std::string& buf)
 {	// sanity checks to avoid buffer overflows via >3 digits to L of decimal point
 	while (lat > 90)	lat -= 360;
 	while (lat < -90)	lat += 360;
 	while (lng >= 540)	lng -= 360;
 	while (lng <= -540)	lng += 360;
-	*fmt::format_to(coordstr, " {:.15} {:.15}", lat, lng) = 0;
+	char str[48];
+	char* end = str;
+	*end++ = ' ';
+	end = format_coord(end, lat);
+	*end++ = ' ';
+	end = format_coord(end, lng);
+	coord_idx = buf.size(); // relative to buf until pool_coordstrs
+	coord_len = end-str;
+	buf.append(str, coord_len);
+}
+
+void HGVertex::pool_coordstrs(std::vector<HGVertex>& vertices, std::string* bufs, unsigned int nbufs)
+{	// bufs hold the coordinate strings of nbufs equal chunks of vertices,
+	// as formatted by VtxFmtThread; concatenate them into coord_pool
+	size_t total = 0;
+	for (unsigned int b = 0; b < nbufs; b++) total += bufs[b].size();
+	coord_pool.resize(total);
+	uint32_t base = 0;
+	for (unsigned int b = 0; b < nbufs; b++)
+	{	memcpy(coord_pool.data()+base, bufs[b].data(), bufs[b].size());
+		for (size_t v = b*vertices.size()/nbufs, end = (b+1)*vertices.size()/nbufs; v < end; v++)
+			vertices[v].coord_idx += base;
+		base += bufs[b].size();
+		std::string().swap(bufs[b]);
+	}
 }
@@ -12,18 +12,21 @@ class HGVertex
     */
 	public:
 	double lat, lng;
-	const std::string *unique_name;
+	const char *unique_name;
 	std::vector<HGEdge*> incident_edges;
+	uint32_t coord_idx;	// " lat lng" coordinate string in coord_pool...
 	uint16_t edge_count;
 	char visibility;
-	char coordstr[45]; // only need 43, but alignment requires extra anyway
+	unsigned char coord_len;// ...& its length, without a null terminator
 
 	static std::atomic_uint num_hidden;
-	static thread_local int* vnums;
+	static std::vector<char> coord_pool; // coordinate strings of all vertices
 
-	void setup(Waypoint*, const std::string*);
+	void setup(Waypoint*, const char*);
 
 	HGEdge* front(unsigned char);
 	HGEdge* back (unsigned char);
-	void format_coordstr();
+	void format_coordstr(std::string&);
+	const char* coordstr() const {return coord_pool.data()+coord_idx;}
+	static void pool_coordstrs(std::vector<HGVertex>&, std::string*, unsigned int);
 };
@@ -1,9 +1,9 @@
-#define FMT_HEADER_ONLY
 #include "HighwayGraph.h"
 #include "GraphListEntry.h"
 #include "HGEdge.h"
 #include "HGVertex.h"
 #include "PlaceRadius.h"
+#include "TMGWriter.h"
 #include "../Args/Args.h"
 #include "../ElapsedTime/ElapsedTime.h"
 #include "../HighwaySegment/HighwaySegment.h"
@@ -14,7 +14,10 @@
 #include "../Waypoint/Waypoint.h"
 #include "../WaypointQuadtree/WaypointQuadtree.h"
 #include "../../templates/contains.cpp"
-#include <fmt/ostream.h>
+#include "tmgb.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <thread>
 
 HighwayGraph::HighwayGraph(WaypointQuadtree &all_waypoints, ElapsedTime &et)
@@ -57,70 +60,105 @@ HighwayGraph::HighwayGraph(WaypointQuadtree &all_waypoints, ElapsedTime &et)
 	counter = 0;
 	std::cout << et.et() << "Creating edges" << std::flush;
 	HGEdge* e = edges.alloc(total_segments + 2*HGVertex::num_hidden);
+	// intern segment names: each distinct name is stored once in HGEdge::names,
+	// & edges (including those collapsed from them) refer to it by index.
+	// Unconcurrent segments are named for their route; look that up once per route.
+	std::unordered_map<std::string, uint32_t> name_ids;
+	auto intern = [&](std::string&& name) -> uint32_t
+	{	auto ins = name_ids.emplace(std::move(name), HGEdge::names.size());
+		if (ins.second) HGEdge::names.push_back(ins.first->first);
+		return ins.first->second;
+	};
 	for (HighwaySystem& h : HighwaySystem::syslist)
 	{	if (!h.active_or_preview()) continue;
 		if (counter % 6 == 0) std::cout << '.' << std::flush;
 		counter++;
 		for (Route& r : h.routes)
+		{ uint32_t route_name = -1;
 		  for (HighwaySegment& s : r.segments)
 		    if (&s == s.canonical_edge_segment())
-		    { ++se; 
-		      new(e++) HGEdge(&s);
+		    { ++se;
+		      if (s.concurrent)
+			new(e++) HGEdge(&s, intern(s.segment_name()));
+		      else {	if (route_name == uint32_t(-1)) route_name = intern(r.list_entry_name());
+				new(e++) HGEdge(&s, route_name);
+			   }
 		    }
+		}
 	}
 	std::cout << '!' << std::endl;
 	ce=te=se;
 
 	// compress edges adjacent to hidden vertices
-	counter = 0;
 	std::cout << et.et() << "Compressing collapsed edges" << std::flush;
 	HGEdge::v_array = vertices.data();
+	std::vector<unsigned int> offsets(vertices.size(), 0);
+	std::vector<std::vector<HGVertex*>> chains(Args::numthreads);
+      #ifdef threading_enabled
+	THRLP = std::thread(&HighwayGraph::set_visibility, this, t); THRLP.join();
+      #else
+	set_visibility(0);
+      #endif
+	std::cout << '.' << std::flush;
+      #ifdef threading_enabled
+	THRLP = std::thread(&HighwayGraph::find_chains, this, t, offsets.data(), chains.data()); THRLP.join();
+      #else
+	find_chains(0, offsets.data(), chains.data());
+      #endif
+	std::cout << '.' << std::flush;
+	// convert edge counts to offsets into edges array, in vertex order
+	unsigned int offset = se;
 	for (HGVertex& v : vertices)
-	{	if (counter % 10000 == 0) std::cout << '.' << std::flush;
-		counter++;
-		if (!v.visibility)
-		{	// <2 edges = HIDDEN_TERMINUS or hidden U-turn
-			// >2 edges = HIDDEN_JUNCTION
-			// datachecks have been flagged earlier in the program; mark as visible and do not compress
-			if (v.edge_count != 2)
+	{	if (v.visibility < 2)
+		{	// unclaimed by any chain = cycle of hidden vertices,
+			// not reachable from a visible one. We're at its lowest
+			// vertex; mark it visible, and compress the rest from it.
+			if (!offsets[&v-vertices.data()])
 			{	v.visibility = 2;
-				continue;
-			}
-			if (!v.incident_edges[0]->segment->same_ap_routes(v.incident_edges[1]->segment))
-			{ /*	std::cout << "\nWARNING: segment name mismatch in HGEdge compression process" << std::endl;
-				std::cout << "  edge1: " << v.incident_edges[0]->segment->segment_name() << std::endl
-					  << "  edge2: " << v.incident_edges[1]->segment->segment_name() << std::endl;
-				std::cout << "  vertex " << *v.unique_name << " unhidden" << std::endl;
-				std::cout << "  waypoints:";
-				Waypoint* w = v.incident_edges[0]->segment->waypoint2;
-				if (w->lat != v.lat || w->lng != v.lng) w = v.incident_edges[0]->segment->waypoint1;
-				for (Waypoint* p : *w->colocated) std::cout << ' ' << p->root_at_label();
-				std::cout << std::endl; //*/
-				v.visibility = 2;
-				continue;
-			}
-			// construct from vertex this time
-			--ce; --cv;
-			// if edge clinched_by sets mismatch, set visibility to 1
-			// (visible in traveled graph; hidden in collapsed graph)
-			uint8_t const coll = HGEdge::collapsed, trav = HGEdge::traveled, dual = coll|trav;
-			HGEdge* const t_front = v.front(trav);
-			HGEdge* const t_back  = v.back (trav);
-			if (t_front->segment->clinched_by != t_back->segment->clinched_by)
-			{	v.visibility = 1;
-				new(e++) HGEdge(&v, coll, v.front(coll), v.back(coll));
-				continue;
+				for (HGEdge* e : v.incident_edges)
+					chain(&v, e, offsets.data(), chains[0]);
 			}
-			if (t_front->format & coll && t_back->format & coll)
-				new(e++) HGEdge(&v, dual, t_front, t_back);
-			else {	new(e++) HGEdge(&v, coll, v.front(coll), v.back(coll));
-				new(e++) HGEdge(&v, trav, t_front, t_back);
+			else {	--ce; --cv;
+				if (!v.visibility) {--te; --tv;}
 			     }
-			--te; --tv;
 		}
+		unsigned int count = offsets[&v-vertices.data()];
+		offsets[&v-vertices.data()] = offset;
+		offset += count;
 	}
+	std::cout << '.' << std::flush;
+      #ifdef threading_enabled
+	THRLP = std::thread(&HighwayGraph::compress, this, t, offsets.data(), chains.data()); THRLP.join();
+      #else
+	compress(0, offsets.data(), chains.data());
+      #endif
+	std::cout << '.' << std::flush;
+	// visible vertices' edge lists were left alone while compressing;
+	// detach temporary edges from them & attach new collapsed ones
+	for (HGVertex& v : vertices)
+	  if (v.visibility == 2)
+	    for (auto i = v.incident_edges.begin(); i != v.incident_edges.end();)
+	      if ((*i)->format) i++;
+	      else i = v.incident_edges.erase(i);
+	for (HGEdge* e = edges.data+se, *end = edges.data+offset; e < end; e++)
+	  if (e->format)
+	  {	if (e->vertex1->visibility == 2) e->vertex1->incident_edges.push_back(e);
+		if (e->vertex2->visibility == 2) e->vertex2->incident_edges.push_back(e);
+	  }
 	std::cout << '!' << std::endl;
-	edges.size = e - edges.data;
+	edges.size = offset;
+
+	// gather intermediate points of collapsed & traveled edges into one contiguous arena
+	std::cout << et.et() << "Storing intermediate points: " << std::flush;
+	size_t num_ip = 0;
+	for (HGEdge& e : edges) num_ip += e.ip_num;
+	HGEdge::ip_arena.resize(num_ip);
+	HGVertex** ip = HGEdge::ip_arena.data();
+	for (HGEdge& e : edges)
+	{	e.get_intermediates(ip);
+		ip += e.ip_num;
+	}
+	std::cout << num_ip << std::endl;
 
 	if (Args::edgecounts)
 	{	std::cout << et.et() << "Edge format counts:" << std::endl;
@@ -146,23 +184,43 @@ HighwayGraph::HighwayGraph(WaypointQuadtree &all_waypoints, ElapsedTime &et)
 		fflush(stdout);
 	}
 
+	// sort live edges by the regions & systems whose edge sets they can be in,
+	// in one pass: count them, convert counts to offsets, then place them.
+	std::cout << et.et() << "Sorting edges by region & system." << std::endl;
+	size_t const num_owners = Region::allregions.size + HighwaySystem::syslist.size;
+	std::vector<std::atomic_uint> ve_pos(num_owners+1);
+      #ifdef threading_enabled
+	THRLP = std::thread(&HighwayGraph::sort_ve_edges, this, t, ve_pos.data()+1, (HGEdge**)0); THRLP.join();
+      #else
+	sort_ve_edges(0, ve_pos.data()+1, 0);
+      #endif
+	for (size_t o = 1; o <= num_owners; o++) ve_pos[o] += ve_pos[o-1];
+	std::vector<unsigned int> ve_offsets(ve_pos.begin(), ve_pos.end());
+	std::vector<HGEdge*> ve_edges(ve_offsets.back());
+      #ifdef threading_enabled
+	THRLP = std::thread(&HighwayGraph::sort_ve_edges, this, t, ve_pos.data(), ve_edges.data()); THRLP.join();
+      #else
+	sort_ve_edges(0, ve_pos.data(), ve_edges.data());
+      #endif
+
 	Region::it = Region::allregions.begin();
 	std::cout << et.et() << "Creating per-region vertex & edge sets." << std::endl;
       #ifdef threading_enabled
-	THRLP = std::thread(&Region::ve_thread, &log_mtx, &vertices, &edges);
+	THRLP = std::thread(&Region::ve_thread, &log_mtx, &vertices, &edges, ve_edges.data(), ve_offsets.data());
 	THRLP.join();
       #else
-	Region::ve_thread(&log_mtx, &vertices, &edges);
+	Region::ve_thread(&log_mtx, &vertices, &edges, ve_edges.data(), ve_offsets.data());
       #endif
 
 	HighwaySystem::it = HighwaySystem::syslist.begin();
 	std::cout << et.et() << "Creating per-system vertex & edge sets." << std::endl;
+	unsigned int* const sys_offsets = ve_offsets.data() + Region::allregions.size;
       #ifdef threading_enabled
-	THRLP = std::thread(&HighwaySystem::ve_thread, &log_mtx, &vertices, &edges);
+	THRLP = std::thread(&HighwaySystem::ve_thread, &log_mtx, &vertices, &edges, ve_edges.data(), sys_offsets);
 	THRLP.join();
 	#undef THRLP
       #else
-	HighwaySystem::ve_thread(&log_mtx, &vertices, &edges);
+	HighwaySystem::ve_thread(&log_mtx, &vertices, &edges, ve_edges.data(), sys_offsets);
       #endif
 
 	if (Args::bitsetlogs)
@@ -174,11 +232,47 @@ HighwayGraph::HighwayGraph(WaypointQuadtree &all_waypoints, ElapsedTime &et)
 	std::cout << et.et() << "Master graph construction complete. Destroying temporary variables." << std::endl;
 } // end ctor
 
-inline std::pair<std::unordered_set<std::string>::iterator,bool> HighwayGraph::vertex_name(std::string& n)
-{	set_mtx[n.back()].lock();
-	std::pair<std::unordered_set<std::string>::iterator,bool> insertion = vertex_names[n.back()].insert(n);
-	set_mtx[n.back()].unlock();
-	return insertion;
+HighwayGraph::~HighwayGraph()
+{	// release the static pools that outlive the graph otherwise
+	std::vector<char>().swap(HGVertex::coord_pool);
+	std::vector<std::string>().swap(HGEdge::names);
+	std::vector<HGVertex*>().swap(HGEdge::ip_arena);
+}
+
+// Call f with the number of each region & system whose edge set can include
+// edge e: its segment's region, numbered by its index in Region::allregions,
+// then each distinct subgraph system in its concurrency group, numbered by its
+// index in HighwaySystem::syslist plus the number of regions.
+// Regions with no active/preview mileage are numbered but never built.
+template <class F> static void ve_owners(HGEdge* e, F f)
+{	f(e->segment->route->region - Region::allregions.data);
+	size_t const sys0 = Region::allregions.size;
+	if (!e->segment->concurrent)
+	{	HighwaySystem* h = e->segment->route->system;
+		if (h->is_subgraph_system) f(sys0 + (h - HighwaySystem::syslist.data));
+		return;
+	}
+	std::list<HighwaySegment*>& c = *e->segment->concurrent;
+	for (auto s = c.begin(); s != c.end(); s++)
+	{	HighwaySystem* h = (*s)->route->system;
+		if (!h->is_subgraph_system) continue;
+		auto p = c.begin();
+		while (p != s && (*p)->route->system != h) p++;
+		if (p == s) f(sys0 + (h - HighwaySystem::syslist.data));
+	}
+}
+
+void HighwayGraph::sort_ve_edges(int t, std::atomic_uint* pos, HGEdge** sorted)
+{	// With sorted null, add this thread's share of live edges to the counts
+	// in pos for each region & system per ve_owners. Otherwise, pos holds
+	// offsets into sorted; store the edges there & advance the offsets.
+	HGEdge* end = edges.data + (t+1)*edges.size/Args::numthreads;
+	for (HGEdge* e = edges.data + t*edges.size/Args::numthreads; e < end; e++)
+	  if (e->format)
+	    ve_owners(e, [&](size_t o)
+	    {	if (sorted) sorted[pos[o]++] = e;
+		else pos[o]++;
+	    });
 }
 
 void HighwayGraph::namelog(std::string&& msg)
@@ -200,36 +294,143 @@ void HighwayGraph::simplify(int t, VInfoVec* points, unsigned int *counter)
 
 		// start with the canonical name and attempt to insert into vertex_names set
 		std::string point_name = vi->first->canonical_waypoint_name(this);
-		std::pair<std::unordered_set<std::string>::iterator,bool> insertion = vertex_name(point_name);
+		std::pair<const char*,bool> insertion = vertex_names.insert(point_name);
 
 		// if that's taken, append the region code
 		if (!insertion.second)
 		{	point_name += "|" + vi->first->route->region->code;
 			namelog("Appended region: " + point_name);
-			insertion = vertex_name(point_name);
+			insertion = vertex_names.insert(point_name);
 		}
 
 		// if that's taken, see if the simple name is available
 		if (!insertion.second)
 		{	std::string simple_name = vi->first->simple_waypoint_name();
-			insertion = vertex_name(simple_name);
+			insertion = vertex_names.insert(simple_name);
 			if (insertion.second)
 				namelog("Revert to simple: " + simple_name + " from (taken) " + point_name);
 			else do // if we have not yet succeeded, add !'s until we do
 			{	point_name += "!";
 				namelog("Appended !: " + point_name);
-				insertion = vertex_name(point_name);
+				insertion = vertex_names.insert(point_name);
 			} while (!insertion.second);
 		}
 
 		// we're good; now set up a vertex
-		vertices[vi->second].setup(vi->first, &*(insertion.first));
+		vertices[vi->second].setup(vi->first, insertion.first);
 
 		// active/preview colocation lists are no longer needed; clear them
 		vi->first->ap_coloc.clear();
 	}
 }
 
+void HighwayGraph::set_visibility(int t)
+{	// decide which hidden vertices can be compressed, before any are
+	auto end = vertices.data() + (t+1)*vertices.size()/Args::numthreads;
+	for (auto v = vertices.data() + t*vertices.size()/Args::numthreads; v < end; v++)
+	  if (!v->visibility)
+	  {	// <2 edges = HIDDEN_TERMINUS or hidden U-turn
+		// >2 edges = HIDDEN_JUNCTION
+		// datachecks have been flagged earlier in the program; mark as visible and do not compress
+		if (v->edge_count != 2 || v->incident_edges[0] == v->incident_edges[1])
+			v->visibility = 2;
+		else if (!v->incident_edges[0]->segment->same_ap_routes(v->incident_edges[1]->segment))
+		{ /*	std::cout << "\nWARNING: segment name mismatch in HGEdge compression process" << std::endl;
+			std::cout << "  edge1: " << v->incident_edges[0]->segment->segment_name() << std::endl
+				  << "  edge2: " << v->incident_edges[1]->segment->segment_name() << std::endl;
+			std::cout << "  vertex " << v->unique_name << " unhidden" << std::endl;
+			std::cout << "  waypoints:";
+			Waypoint* w = v->incident_edges[0]->segment->waypoint2;
+			if (w->lat != v->lat || w->lng != v->lng) w = v->incident_edges[0]->segment->waypoint1;
+			for (Waypoint* p : *w->colocated) std::cout << ' ' << p->root_at_label();
+			std::cout << std::endl; //*/
+			v->visibility = 2;
+		}
+		// if edge clinched_by sets mismatch, set visibility to 1
+		// (visible in traveled graph; hidden in collapsed graph)
+		// Traveled edges only ever span vertices where they match,
+		// so comparing the 2 original segments here is equivalent
+		// to comparing the traveled edges at compression time.
+		else if (v->incident_edges[0]->segment->clinched_by != v->incident_edges[1]->segment->clinched_by)
+			v->visibility = 1;
+	  }
+}
+
+void HighwayGraph::find_chains(int t, unsigned int* counts, std::vector<HGVertex*>* chains)
+{	// find chains of compressible vertices leading from visible vertices in this thread's range
+	auto end = vertices.data() + (t+1)*vertices.size()/Args::numthreads;
+	for (auto a = vertices.data() + t*vertices.size()/Args::numthreads; a < end; a++)
+	  if (a->visibility == 2)
+	    for (HGEdge* e : a->incident_edges)
+		chain(a, e, counts, chains[t]);
+}
+
+void HighwayGraph::chain(HGVertex* a, HGEdge* e, unsigned int* counts, std::vector<HGVertex*>& c)
+{	// Walk a chain of compressible vertices from visible vertex a via edge e.
+	// Each chain is found from both ends; it belongs to the end with the
+	// lower-addressed edge. If that's this one, store its vertices in c,
+	// followed by a null separator, and count the edges each will create.
+	size_t const first = c.size();
+	HGEdge* const e0 = e;
+	for (HGVertex* v = a; (v = e->vertex1 == v ? e->vertex2 : e->vertex1)->visibility < 2;)
+	{	c.push_back(v);
+		for (HGEdge* i : v->incident_edges)
+		  if (i != e)
+		  {	e = i;
+			break;
+		  }
+	}
+	if (c.size() == first) return;
+	if (e0 > e) return c.resize(first);
+
+	// The serial compression process went in vertex order, so that a
+	// hidden vertex creates separate collapsed & traveled edges rather
+	// than 1 edge in both graphs if, on either side, the nearest vertex
+	// that's visible in the traveled graph or processed after it is one
+	// visible only in the traveled graph, processed before it.
+	HGVertex **b = c.data()+first, **z = c.data()+c.size();
+	HGVertex *barrier = 0, *max = 0;
+	for (HGVertex** v = b; v < z; v++)
+	  if ((*v)->visibility)	barrier = max = *v;
+	  else {	if (barrier && *v > max) counts[*v-vertices.data()] = 1;
+			if (*v > max) max = *v;
+	       }
+	barrier = max = 0;
+	for (HGVertex** v = z; v-- > b;)
+	  if ((*v)->visibility)	barrier = max = *v;
+	  else {	if (barrier && *v > max) counts[*v-vertices.data()] = 1;
+			if (*v > max) max = *v;
+	       }
+	for (HGVertex** v = b; v < z; v++) counts[*v-vertices.data()]++;
+
+	// compress in vertex order, to create the same edges as the serial process
+	std::sort(b, z);
+	c.push_back(0);
+}
+
+void HighwayGraph::compress(int t, unsigned int* offsets, std::vector<HGVertex*>* chains)
+{	// compress this thread's chains, constructing edges at the
+	// same positions in the edges array the serial process would
+	uint8_t const coll = HGEdge::collapsed, trav = HGEdge::traveled, dual = coll|trav;
+	for (HGVertex* v : chains[t])
+	{	if (!v) continue;
+		HGEdge* e = edges.data + offsets[v-vertices.data()];
+		if (v->visibility)
+		{	new(e) HGEdge(v, coll, v->front(coll), v->back(coll));
+			continue;
+		}
+		HGEdge* const t_front = v->front(trav);
+		HGEdge* const t_back  = v->back (trav);
+		if (t_front->format & coll && t_back->format & coll)
+			new(e) HGEdge(v, dual, t_front, t_back);
+		else {	new(e++) HGEdge(v, coll, v->front(coll), v->back(coll));
+			new(e) HGEdge(v, trav, t_front, t_back);
+		     }
+	}
+	chains[t].clear();
+	chains[t].shrink_to_fit();
+}
+
 void HighwayGraph::bitsetlogs(HGVertex* hp_end)
 {	size_t oldvheap = sizeof(uint64_t) * ceil(double(vertices.size()+1)/(sizeof(uint64_t)*8));
 	size_t oldeheap = sizeof(uint64_t) * ceil(double(edges.size+1)/(sizeof(uint64_t)*8));
@@ -247,19 +448,21 @@ void HighwayGraph::bitsetlogs(HGVertex* hp_end)
 	}
 	std::cout << "final_s = " << final_s << ": " << edges[final_s].str() << std::endl;
 	std::cout << "first_c = " << first_c << ": " << edges[first_c].str() << std::endl;
-	std::cout << "low_pri = " << low_pri << ": " << edges[low_pri].str() << " ~~ " << *hp_end->unique_name << std::endl;
+	std::cout << "low_pri = " << low_pri << ": " << edges[low_pri].str() << " ~~ " << hp_end->unique_name << std::endl;
 	std::cout << "total_e = " << edges.size << std::endl;
 
 	std::ofstream vramlog(Args::logfilepath+"/tmb-region-vram.csv");
 	std::ofstream eramlog(Args::logfilepath+"/tmb-region-eram.csv");
 	std::ofstream vgaplog(Args::logfilepath+"/tmb-region-vgap.csv");
 	std::ofstream egaplog(Args::logfilepath+"/tmb-region-egap.csv");
-	using x = TMBitset<void*,uint64_t>*;
+	using x = TMRoaring<void*>*;
+	// NewHeap is what the set would take as a TMBitset; Saved, the savings from compressing it
 	auto ramlogline=[](x tmb, std::string& code, std::ofstream& log, size_t old_heap)
 	{	log << code << ';' << tmb->count() << ';' << old_heap << ';'<< tmb->vec_cap() 
-		    << ';' << tmb->vec_size() << ';' << tmb->heap() << std::endl;
+		    << ';' << tmb->vec_size() << ';' << tmb->tmb_heap() << ';' << tmb->heap()
+		    << ';' << long(tmb->tmb_heap() - tmb->heap()) << std::endl;
 	};
-	auto vgaplogline=[&](TMBitset<HGVertex*,uint64_t>& tmb, std::string& code, HGVertex* start)
+	auto vgaplogline=[&](TMRoaring<HGVertex*>& tmb, std::string& code, HGVertex* start)
 	{	HGVertex *lo_v, *hi_v, *lo_g, *hi_g, *prev;
 		lo_v = *tmb.begin();
 		prev = lo_v;
@@ -274,12 +477,12 @@ void HighwayGraph::bitsetlogs(HGVertex* hp_end)
 			prev = v;
 		}
 		vgaplog << code
-			<< ';' << lo_v-start << ';' << *lo_v->unique_name << ';' << gap
-			<< ';' << lo_g-start << ';' << *lo_g->unique_name << ';' << (lo_g < hp_end ? "hi" : "lo")
-			<< ';' << hi_g-start << ';' << *hi_g->unique_name << ';' << (hi_g < hp_end ? "hi" : "lo")
-			<< ';' << hi_v-start << ';' << *hi_v->unique_name << std::endl;
+			<< ';' << lo_v-start << ';' << lo_v->unique_name << ';' << gap
+			<< ';' << lo_g-start << ';' << lo_g->unique_name << ';' << (lo_g < hp_end ? "hi" : "lo")
+			<< ';' << hi_g-start << ';' << hi_g->unique_name << ';' << (hi_g < hp_end ? "hi" : "lo")
+			<< ';' << hi_v-start << ';' << hi_v->unique_name << std::endl;
 	};
-	auto egaplogline=[&](TMBitset<HGEdge*,uint64_t>& tmb, std::string& code, HGEdge* start)
+	auto egaplogline=[&](TMRoaring<HGEdge*>& tmb, std::string& code, HGEdge* start)
 	{	HGEdge *lo_e, *hi_e, *lo_g1, *hi_g1, *lo_g2, *hi_g2, *prev;
 		lo_e = *tmb.begin();
 		prev = lo_e;
@@ -308,8 +511,8 @@ void HighwayGraph::bitsetlogs(HGVertex* hp_end)
 			<< ';' << hi_e -start << ';' <<    hi_e->str()    << std::endl;
 	};
 
-	vramlog << "Region" << ";Count;OldHeap;VecCap;VecSize;NewHeap\n";
-	eramlog << "Region" << ";Count;OldHeap;VecCap;VecSize;NewHeap\n";
+	vramlog << "Region" << ";Count;OldHeap;VecCap;VecSize;NewHeap;Roaring;Saved\n";
+	eramlog << "Region" << ";Count;OldHeap;VecCap;VecSize;NewHeap;Roaring;Saved\n";
 	vgaplog << "Region" << ";LoIndex;LoName;gap;Beg;BegPt;BegPri;End;EndPt;EndPri;HiIndex;HiName\n";
 	egaplog << "Region" << ";LoIndex;LoInfo"
 			    << ";gap1;Beg1;BegInfo1;BegPri1;End1;EndInfo1;EndPri1"
@@ -330,8 +533,8 @@ void HighwayGraph::bitsetlogs(HGVertex* hp_end)
 	vgaplog.close(); vgaplog.open(Args::logfilepath+"/tmb-system-vgap.csv");
 	egaplog.close(); egaplog.open(Args::logfilepath+"/tmb-system-egap.csv");
 
-	vramlog << "System" << ";Count;OldHeap;VecCap;VecSize;NewHeap\n";
-	eramlog << "System" << ";Count;OldHeap;VecCap;VecSize;NewHeap\n";
+	vramlog << "System" << ";Count;OldHeap;VecCap;VecSize;NewHeap;Roaring;Saved\n";
+	eramlog << "System" << ";Count;OldHeap;VecCap;VecSize;NewHeap;Roaring;Saved\n";
 	vgaplog << "System" << ";LoIndex;LoName;gap;Beg;BegPt;BegPri;End;EndPt;EndPri;HiIndex;HiName\n";
 	egaplog << "System" << ";LoIndex;LoInfo"
 			    << ";gap1;Beg1;BegInfo1;BegPri1;End1;EndInfo1;EndPri1"
@@ -348,7 +551,19 @@ void HighwayGraph::bitsetlogs(HGVertex* hp_end)
 	}
 }
 
-// write the entire set of highway data in .tmg format.
+void HighwayGraph::build_csr()
+{	// CSR adjacency of the simple, collapsed & traveled master graphs
+	unsigned char const fmt[3] = {HGEdge::simple, HGEdge::collapsed, HGEdge::traveled};
+      #ifdef threading_enabled
+	std::thread thr[3];
+	for (int f = 0; f < 3; f++) thr[f] = std::thread(&HGCSR::build, csr+f, std::ref(vertices), std::ref(edges), fmt[f]);
+	for (int f = 0; f < 3; f++) thr[f].join();
+      #else
+	for (int f = 0; f < 3; f++) csr[f].build(vertices, edges, fmt[f]);
+      #endif
+}
+
+// write the entire set of highway data in .tmg format, in the formats selected.
 // The first line is a header specifying the format and version number,
 // The second line specifies the number of waypoints, w, the number of connections, c,
 //     and for traveled graphs only, the number of travelers.
@@ -358,27 +573,50 @@ void HighwayGraph::bitsetlogs(HGVertex* hp_end)
 //     followed on both collapsed & traveled graphs by a list of latitude & longitude values
 //     for intermediate "shaping points" along the edge, ordered from endpoint 1 to endpoint 2.
 //
-void HighwayGraph::write_master_graphs_tmg()
-{	std::ofstream simplefile(Args::graphfilepath + "/tm-master-simple.tmg");
-	std::ofstream collapfile(Args::graphfilepath + "/tm-master.tmg");
-	std::ofstream travelfile(Args::graphfilepath + "/tm-master-traveled.tmg");
+void HighwayGraph::write_master_graphs_tmg(unsigned char formats)
+{	GraphListEntry* g = GraphListEntry::entries.data();
+	// formats is a mask of HGEdge::format bits, for files to write, as for subgraphs
+	TMGWriter simplefile, collapfile, travelfile;
+	if (formats & HGEdge::simple)	 simplefile.open(Args::graphfilepath+'/'+g[0].filename());
+	if (formats & HGEdge::collapsed) collapfile.open(Args::graphfilepath+'/'+g[1].filename());
+	if (formats & HGEdge::traveled)	 travelfile.open(Args::graphfilepath+'/'+g[2].filename());
 	simplefile << "TMG 1.0 simple\n";
 	collapfile << "TMG 1.0 collapsed\n";
 	travelfile << "TMG 2.0 traveled\n";
 	simplefile << vertices.size() << ' ' << se << '\n';
 	collapfile << cv << ' ' << ce << '\n';
 	travelfile << tv << ' ' << te << ' ' << TravelerList::allusers.size << '\n';
+	TMGBBuilder *simplebin = 0, *collapbin = 0, *travelbin = 0;
+	if (Args::binarygraphs)
+	{	if (formats & HGEdge::simple)	 simplebin = new TMGBBuilder(TMGB_SIMPLE, 0);
+		if (formats & HGEdge::collapsed) collapbin = new TMGBBuilder(TMGB_COLLAPSED, 0);
+		if (formats & HGEdge::traveled)	 travelbin = new TMGBBuilder(TMGB_TRAVELED, TravelerList::allusers.size);
+						 // deleted once written
+	}
+	GraphStats *simplestats = 0, *collapstats = 0, *travelstats = 0;
+	if (Args::graphstats)
+	{	if (formats & HGEdge::simple)	 simplestats = &g[0].stats;
+		if (formats & HGEdge::collapsed) collapstats = &g[1].stats;
+		if (formats & HGEdge::traveled)	 travelstats = &g[2].stats;
+	}
 
 	// write vertices
 	unsigned int sv = 0;
 	unsigned int cv = 0;
 	unsigned int tv = 0;
-	int* vnum = HGVertex::vnums;
+	std::vector<int> vnums(vertices.size()*3);
+	int* vnum = vnums.data();
 	for (HGVertex& v : vertices)
 	{	switch (v.visibility) // fall-thru is a Good Thing!
-		{ case 2:  collapfile << *(v.unique_name) << v.coordstr << '\n'; vnum[1] = cv++;
-		  case 1:  travelfile << *(v.unique_name) << v.coordstr << '\n'; vnum[2] = tv++;
-		  default: simplefile << *(v.unique_name) << v.coordstr << '\n'; vnum[0] = sv++;
+		{ case 2:  (collapfile << v.unique_name).write(v.coordstr(), v.coord_len) << '\n'; vnum[1] = cv++;
+			   if (collapbin) collapbin->vertex(v.unique_name, v.lat, v.lng);
+			   if (collapstats) collapstats->vertex(v.lat, v.lng);
+		  case 1:  (travelfile << v.unique_name).write(v.coordstr(), v.coord_len) << '\n'; vnum[2] = tv++;
+			   if (travelbin) travelbin->vertex(v.unique_name, v.lat, v.lng);
+			   if (travelstats) travelstats->vertex(v.lat, v.lng);
+		  default: (simplefile << v.unique_name).write(v.coordstr(), v.coord_len) << '\n'; vnum[0] = sv++;
+			   if (simplebin) simplebin->vertex(v.unique_name, v.lat, v.lng);
+			   if (simplestats) simplestats->vertex(v.lat, v.lng);
 			   vnum += 3;
 		}
 	}
@@ -392,80 +630,284 @@ void HighwayGraph::write_master_graphs_tmg()
 	// write edges
 	//TODO: multiple functions performing the same instructions for multiple files?
 	for (HGEdge *e = edges.begin(), *end = edges.end(); e != end; ++e)
-	{ int* v1num = HGVertex::vnums+(e->vertex1-vertices.data())*3;
-	  int* v2num = HGVertex::vnums+(e->vertex2-vertices.data())*3;
-
-	  if (e->format & HGEdge::collapsed)
-	  {	fmt::print(collapfile, "{} {} ", v1num[1], v2num[1]);
-		collapfile << e->segment_name;
-		for (HGVertex *intermediate : e->intermediate_points)
-			collapfile << intermediate->coordstr;
+	{ int* v1num = vnums.data()+(e->vertex1-vertices.data())*3;
+	  int* v2num = vnums.data()+(e->vertex2-vertices.data())*3;
+
+	  if (e->format & formats & HGEdge::collapsed)
+	  {	collapfile << v1num[1] << ' ' << v2num[1] << ' ';
+		collapfile << e->segment_name();
+		for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+			collapfile.write((*ip)->coordstr(), (*ip)->coord_len);
 		collapfile << '\n';
+		if (collapbin)
+		{	collapbin->edge(v1num[1], v2num[1], e->segment_name());
+			for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+				collapbin->point((*ip)->lat, (*ip)->lng);
+		}
+		if (collapstats) collapstats->edge(v1num[1], v2num[1]);
 	  }
-	  if (e->format & HGEdge::traveled)
-	  {	for (char*n=cbycode; n<cbycode+nibbles; ++n) *n = '0';
-		fmt::print(travelfile, "{} {} ", v1num[2], v2num[2]);
-		travelfile << e->segment_name;
-		travelfile << ' ' << (TravelerList::allusers.size ? e->segment->clinchedby_code(cbycode, 0) : "0");
-		for (HGVertex *intermediate : e->intermediate_points)
-			travelfile << intermediate->coordstr;
+	  if (e->format & formats & HGEdge::traveled)
+	  {	const char* code = TravelerList::allusers.size ? e->segment->clinchedby_code(cbycode, nullptr) : "0";
+		travelfile << v1num[2] << ' ' << v2num[2] << ' ';
+		travelfile << e->segment_name();
+		travelfile << ' ' << code;
+		for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+			travelfile.write((*ip)->coordstr(), (*ip)->coord_len);
 		travelfile << '\n';
+		if (travelbin)
+		{	travelbin->edge(v1num[2], v2num[2], e->segment_name());
+			travelbin->clinched_by(code);
+			for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+				travelbin->point((*ip)->lat, (*ip)->lng);
+		}
+		if (travelstats) travelstats->edge(v1num[2], v2num[2]);
 	  }
-	  if (e->format & HGEdge::simple)
-	  {	fmt::print(simplefile, "{} {} ", v1num[0], v2num[0]);
-		simplefile << e->segment_name;
+	  if (e->format & formats & HGEdge::simple)
+	  {	simplefile << v1num[0] << ' ' << v2num[0] << ' ';
+		simplefile << e->segment_name();
 		simplefile << '\n';
+		if (simplebin) simplebin->edge(v1num[0], v2num[0], e->segment_name());
+		if (simplestats) simplestats->edge(v1num[0], v2num[0]);
 	  }
 	}
 	delete[] cbycode;
 
 	// traveler names
 	for (TravelerList& t : TravelerList::allusers)
-		travelfile << t.traveler_name << ' ';
+	{	travelfile << t.traveler_name << ' ';
+		if (travelbin) travelbin->traveler(t.traveler_name);
+	}
 	travelfile << '\n';
 	simplefile.close();
 	collapfile.close();
 	travelfile.close();
-	GraphListEntry* g = GraphListEntry::entries.data();
+	if (simplebin) {simplebin->write(Args::graphfilepath+'/'+g[0].stem()+".tmgb"); delete simplebin;}
+	if (collapbin) {collapbin->write(Args::graphfilepath+'/'+g[1].stem()+".tmgb"); delete collapbin;}
+	if (travelbin) {travelbin->write(Args::graphfilepath+'/'+g[2].stem()+".tmgb"); delete travelbin;}
+	if (simplestats) simplestats->finish();
+	if (collapstats) collapstats->finish();
+	if (travelstats) travelstats->finish();
+	if (formats & HGEdge::intonly)
+	{	std::vector<HGVertex*> cverts;
+		std::vector<HGEdge*> cedges;
+		std::vector<uint32_t> ends;
+		for (HGVertex& v : vertices)
+		  if (v.visibility == 2) cverts.push_back(&v);
+		for (HGEdge& e : edges)
+		  if (e.format & HGEdge::collapsed)
+		  {	cedges.push_back(&e);
+			ends.push_back(vnums[(e.vertex1-vertices.data())*3+1]);
+			ends.push_back(vnums[(e.vertex2-vertices.data())*3+1]);
+		  }
+		write_intonly_tmg(g+1, cverts, cedges, ends);
+	}
 	g[0].vertices = vertices.size(); g[0].edges = se; g[0].travelers = 0;
 	g[1].vertices = cv;		 g[1].edges = ce; g[1].travelers = 0;
 	g[2].vertices = tv;		 g[2].edges = te; g[2].travelers = TravelerList::allusers.size;
 }
 
+// append a kind of criterion, & the sorted, unique items it lists, to a ve_cache key
+template <class T> static void ve_key_append(std::string& key, char kind, std::vector<T*>& items)
+{	std::sort(items.begin(), items.end());
+	items.erase(std::unique(items.begin(), items.end()), items.end());
+	size_t const n = items.size();
+	key += kind;
+	key.append((const char*)&n, sizeof(n));
+	key.append((const char*)items.data(), n*sizeof(T*));
+}
+
+// identify the regions, systems & placeradius a subgraph's vertex & edge sets are selected by
+std::string HighwayGraph::ve_key(GraphListEntry* g)
+{	std::string key;
+	if (g->regions)
+	{	std::vector<Region*> r(*g->regions);
+		ve_key_append(key, 'r', r);
+	}
+	if (g->systems)
+	{	std::vector<HighwaySystem*> h(*g->systems);
+		ve_key_append(key, 's', h);
+	}
+	if (g->placeradius)
+	{	key += 'p';
+		key.append((const char*)&g->placeradius, sizeof(g->placeradius));
+	}
+	return key;
+}
+
+// Note one more user of the union of these regions' vertex & edge sets.
+// Where a list has all of a country's regions with mileage, they're taken
+// as one part, the same union as that country's graph, so continent &
+// multi-region graphs reuse it rather than redoing it.
+HighwayGraph::VESets* HighwayGraph::ve_regions(std::vector<Region*> regions)
+{	std::string key;
+	ve_key_append(key, 'r', regions);
+	VESets& s = ve_cache[key];
+	if (s.users++) return &s;
+	std::unordered_map<std::pair<std::string, std::string>*, std::vector<Region*>> by_country;
+	for (Region* r : regions)
+	  if (r->active_preview_mileage)
+		by_country[r->country].push_back(r);
+	  else	s.regions.push_back(r);
+	for (auto& c : by_country)
+	{	size_t in_country = 0;
+		for (Region& r : Region::allregions)
+		  if (r.country == c.first && r.active_preview_mileage)
+			in_country++;
+		if (in_country >= 2 && c.second.size() == in_country && in_country < regions.size())
+			s.parts.push_back(ve_regions(c.second));
+		else	s.regions.insert(s.regions.end(), c.second.begin(), c.second.end());
+	}
+	return &s;
+}
+
+// note one more user of the union of these systems' vertex & edge sets
+HighwayGraph::VESets* HighwayGraph::ve_systems(std::vector<HighwaySystem*> systems)
+{	std::string key;
+	ve_key_append(key, 's', systems);
+	VESets& s = ve_cache[key];
+	if (!s.users++) s.systems = systems;
+	return &s;
+}
+
+// Note one more subgraph task that'll look up the vertex & edge sets for this entry,
+// and the entries they're made from, so that sets selected by the same criteria
+// are only computed once, and kept only until no longer needed.
+void HighwayGraph::ve_expect(size_t graphnum)
+{	GraphListEntry* g = GraphListEntry::entries.data()+graphnum;
+	if (!g->placeradius)
+	{	if (!g->systems) {ve_regions(*g->regions); return;}
+		if (!g->regions) {ve_systems(*g->systems); return;}
+	}
+	VESets& s = ve_cache[ve_key(g)];
+	if (s.users++) return;
+	s.intersection = 1;
+	s.placeradius = g->placeradius;
+	if (g->regions) s.parts.push_back(ve_regions(*g->regions));
+	if (g->systems) s.parts.push_back(ve_systems(*g->systems));
+}
+
+// compute an entry's sets, after those of the entries they're made from,
+// unless already done, waiting for them if another thread is at it
+void HighwayGraph::ve_make(VESets& s, WaypointQuadtree* qt)
+{	std::unique_lock<std::mutex> lock(ve_mtx);
+	while (s.state == 1) ve_cv.wait(lock);
+	if (s.state == 2) return;
+	s.state = 1;
+	lock.unlock();
+
+	std::vector<TMBitset<HGVertex*, uint64_t>*> in_mv;
+	std::vector<TMBitset<HGEdge*,   uint64_t>*> in_me;
+	for (VESets* p : s.parts)
+	{	ve_make(*p, qt);
+		in_mv.push_back(&p->mv);
+		in_me.push_back(&p->me);
+	}
+	if (s.placeradius)
+	{	TMBitset<HGVertex*, uint64_t> pr_mv;
+		TMBitset<HGEdge*,   uint64_t> pr_me;
+		pr_mv.alloc(vertices.data(), vertices.size());
+		pr_me.alloc(edges.data, edges.size);
+		s.placeradius->matching_ve(pr_mv, pr_me, qt);
+		pr_mv.shrink_to_fit();
+		pr_me.shrink_to_fit();
+		if (in_mv.empty())
+		{	s.mv.swap(pr_mv);
+			s.me.swap(pr_me);
+		}
+		else {	in_mv.push_back(&pr_mv);
+			in_me.push_back(&pr_me);
+			s.mv.assign_intersection(in_mv.data(), in_mv.size());
+			s.me.assign_intersection(in_me.data(), in_me.size());
+		     }
+	}
+	else if (s.intersection)
+	{	s.mv.assign_intersection(in_mv.data(), in_mv.size());
+		s.me.assign_intersection(in_me.data(), in_me.size());
+	}
+	else {	std::vector<const TMRoaring<HGVertex*>*> r_mv;
+		std::vector<const TMRoaring<HGEdge*>*>   r_me;
+		for (Region* r : s.regions)
+		{	r_mv.push_back(&r->vertices);
+			r_me.push_back(&r->edges);
+		}
+		for (HighwaySystem* h : s.systems)
+		{	r_mv.push_back(&h->vertices);
+			r_me.push_back(&h->edges);
+		}
+		s.mv.assign_union(in_mv.data(), in_mv.size(), r_mv.data(), r_mv.size());
+		s.me.assign_union(in_me.data(), in_me.size(), r_me.data(), r_me.size());
+	     }
+
+	lock.lock();
+	for (VESets* p : s.parts)
+	  if (!--p->users)
+	  {	TMBitset<HGVertex*, uint64_t>().swap(p->mv);
+		TMBitset<HGEdge*,   uint64_t>().swap(p->me);
+	  }
+	s.state = 2;
+	lock.unlock();
+	ve_cv.notify_all();
+}
+
+// Give a user of an entry its sets: moved out if it's the last one, else copied.
+// mv & me must be default-constructed; ve_mtx must be locked.
+void HighwayGraph::VESets::take(TMBitset<HGVertex*, uint64_t>& v, TMBitset<HGEdge*, uint64_t>& e)
+{	if (--users)
+	{	v = mv;
+		e = me;
+	}
+	else {	v.swap(mv);
+		e.swap(me);
+	     }
+}
+
+// Find sets of vertices & edges from the graph, optionally
+// restricted by region or system or placeradius area.
+void HighwayGraph::ve_sets
+(	GraphListEntry* g, WaypointQuadtree* qt, TMBitset<HGVertex*, uint64_t>& mv, TMBitset<HGEdge*, uint64_t>& me
+)
+{	VESets& s = ve_cache.at(ve_key(g));
+	ve_make(s, qt);
+	std::lock_guard<std::mutex> lock(ve_mtx);
+	s.take(mv, me);
+}
+
 // write a subset of the data,
 // in simple, collapsed and traveled formats,
 // restricted by regions in the list if given,
 // by systems in the list if given,
 // or to within a given area if placeradius is given
 void HighwayGraph::write_subgraphs_tmg
-(	size_t graphnum, unsigned int threadnum, WaypointQuadtree *qt, ElapsedTime *et, std::mutex *term
+(	size_t graphnum, unsigned char formats, WaypointQuadtree *qt, ElapsedTime *et, std::mutex *term
 )
 {	unsigned int cv_count = 0, sv_count = 0, tv_count = 0;
 	unsigned int ce_count = 0, se_count = 0, te_count = 0;
 	GraphListEntry* g = GraphListEntry::entries.data()+graphnum;
-	std::ofstream simplefile(Args::graphfilepath+'/'+g -> filename());
-	std::ofstream collapfile(Args::graphfilepath+'/'+g[1].filename());
-	std::ofstream travelfile(Args::graphfilepath+'/'+g[2].filename());
+	// formats is a mask of HGEdge::format bits, for files to write.
+	// Files not written are never opened, and their output discarded.
+	TMGWriter simplefile, collapfile, travelfile;
+	if (formats & HGEdge::simple)	 simplefile.open(Args::graphfilepath+'/'+g -> filename());
+	if (formats & HGEdge::collapsed) collapfile.open(Args::graphfilepath+'/'+g[1].filename());
+	if (formats & HGEdge::traveled)	 travelfile.open(Args::graphfilepath+'/'+g[2].filename());
 	TMBitset<HGVertex*, uint64_t> mv; // vertices matching all criteria
 	TMBitset<HGEdge*,   uint64_t> me; //    edges matching all criteria
 	std::vector<TravelerList*> traveler_lists;
 	TMBitset<TravelerList*, uint32_t> traveler_set(TravelerList::allusers.data, TravelerList::allusers.size);
 	#include "get_subgraph_data.cpp"
-	// assign traveler numbers
-	unsigned int travnum = 0;
-	for (TravelerList *t : traveler_set)
-	{	t->traveler_num[threadnum] = travnum++;
-		traveler_lists.push_back(t);
-	}
+	// list travelers, numbered in this order in clinched_by codes
+	for (TravelerList *t : traveler_set) traveler_lists.push_back(t);
+	unsigned int travnum = traveler_lists.size();
       #ifdef threading_enabled
 	term->lock();
       #endif
-	if (g->cat != g[-1].cat)
-		std::cout << '\n' << et->et() << "Writing " << g->category() << " graphs.\n";
-	std::cout << g->tag()
-		  << '(' << sv_count << ',' << se_count << ") "
-		  << '(' << cv_count << ',' << ce_count << ") "
-		  << '(' << tv_count << ',' << te_count << ") " << std::flush;
+	static char cat = 'M'; // category most recently announced
+	if (g->cat != cat)
+		std::cout << '\n' << et->et() << "Writing " << (cat = g->cat, g->category()) << " graphs.\n";
+	std::cout << g->tag();
+	if (formats & HGEdge::simple)	 std::cout << '(' << sv_count << ',' << se_count << ") ";
+	if (formats & HGEdge::collapsed) std::cout << '(' << cv_count << ',' << ce_count << ") ";
+	if (formats & HGEdge::traveled)	 std::cout << '(' << tv_count << ',' << te_count << ") ";
+	std::cout << std::flush;
       #ifdef threading_enabled
 	term->unlock();
       #endif
@@ -475,13 +917,34 @@ void HighwayGraph::write_subgraphs_tmg
 	simplefile << sv_count << ' ' << se_count << '\n';
 	collapfile << cv_count << ' ' << ce_count << '\n';
 	travelfile << tv_count << ' ' << te_count << ' ' << travnum << '\n';
+	// binary counterparts of the files written, if any
+	TMGBBuilder *simplebin = 0, *collapbin = 0, *travelbin = 0;
+	if (Args::binarygraphs)
+	{	if (formats & HGEdge::simple)	 simplebin = new TMGBBuilder(TMGB_SIMPLE, 0);
+		if (formats & HGEdge::collapsed) collapbin = new TMGBBuilder(TMGB_COLLAPSED, 0);
+		if (formats & HGEdge::traveled)	 travelbin = new TMGBBuilder(TMGB_TRAVELED, travnum);
+						 // deleted once written
+	}
+	// statistics of the files written, if requested
+	GraphStats *simplestats = 0, *collapstats = 0, *travelstats = 0;
+	if (Args::graphstats)
+	{	if (formats & HGEdge::simple)	 simplestats = &g->stats;
+		if (formats & HGEdge::collapsed) collapstats = &g[1].stats;
+		if (formats & HGEdge::traveled)	 travelstats = &g[2].stats;
+	}
 
 	// write vertices
-	for (HGVertex *v : mv)
+	for (HGVertex *v : vlist)
 	{	switch(v->visibility) // fall-thru is a Good Thing!
-		{ case 2:  collapfile << *(v->unique_name) << v->coordstr << '\n';
-		  case 1:  travelfile << *(v->unique_name) << v->coordstr << '\n';
-		  default: simplefile << *(v->unique_name) << v->coordstr << '\n';
+		{ case 2:  if (formats & HGEdge::collapsed) (collapfile << v->unique_name).write(v->coordstr(), v->coord_len) << '\n';
+			   if (collapbin) collapbin->vertex(v->unique_name, v->lat, v->lng);
+			   if (collapstats) collapstats->vertex(v->lat, v->lng);
+		  case 1:  if (formats & HGEdge::traveled)  (travelfile << v->unique_name).write(v->coordstr(), v->coord_len) << '\n';
+			   if (travelbin) travelbin->vertex(v->unique_name, v->lat, v->lng);
+			   if (travelstats) travelstats->vertex(v->lat, v->lng);
+		  default: if (formats & HGEdge::simple)    (simplefile << v->unique_name).write(v->coordstr(), v->coord_len) << '\n';
+			   if (simplebin) simplebin->vertex(v->unique_name, v->lat, v->lng);
+			   if (simplestats) simplestats->vertex(v->lat, v->lng);
 		}
 	}
 
@@ -492,52 +955,210 @@ void HighwayGraph::write_subgraphs_tmg
 	cbycode[nibbles] = 0;
 
 	// write edges
-	for (HGEdge *e : me) //TODO: multiple functions performing the same instructions for multiple files?
-	{ int* v1num = HGVertex::vnums+(e->vertex1-vertices.data())*3;
-	  int* v2num = HGVertex::vnums+(e->vertex2-vertices.data())*3;
-
-	  if (e->format & HGEdge::simple)
-	  {	fmt::print(simplefile, "{} {} ", v1num[0], v2num[0]);
-		if (g->systems)
-			e->segment->write_label(simplefile, g->systems);
-		else	simplefile << e->segment_name;
+	std::string syslabel;
+	for (HGEdge *e : elist) //TODO: multiple functions performing the same instructions for multiple files?
+	{ int* v1num = vnums.data()+mv.rank(vrank, e->vertex1)*3;
+	  int* v2num = vnums.data()+mv.rank(vrank, e->vertex2)*3;
+	  const std::string* label = &e->segment_name();
+	  if (g->systems)
+	  {	syslabel.clear();
+		e->segment->write_label(syslabel, g->systems);
+		label = &syslabel;
+	  }
+
+	  if (e->format & formats & HGEdge::simple)
+	  {	simplefile << v1num[0] << ' ' << v2num[0] << ' ';
+		simplefile << *label;
 		simplefile << '\n';
+		if (simplebin) simplebin->edge(v1num[0], v2num[0], *label);
+		if (simplestats) simplestats->edge(v1num[0], v2num[0]);
 	  }
-	  if (e->format & HGEdge::collapsed)
-	  {	fmt::print(collapfile, "{} {} ", v1num[1], v2num[1]);
-		if (g->systems)
-			e->segment->write_label(collapfile, g->systems);
-		else	collapfile << e->segment_name;
-		for (HGVertex *intermediate : e->intermediate_points)
-			collapfile << intermediate->coordstr;
+	  if (e->format & formats & HGEdge::collapsed)
+	  {	collapfile << v1num[1] << ' ' << v2num[1] << ' ';
+		collapfile << *label;
+		for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+			collapfile.write((*ip)->coordstr(), (*ip)->coord_len);
 		collapfile << '\n';
+		if (collapbin)
+		{	collapbin->edge(v1num[1], v2num[1], *label);
+			for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+				collapbin->point((*ip)->lat, (*ip)->lng);
+		}
+		if (collapstats) collapstats->edge(v1num[1], v2num[1]);
 	  }
-	  if (e->format & HGEdge::traveled)
-	  {	for (char*n=cbycode; n<cbycode+nibbles; ++n) *n = '0';
-		fmt::print(travelfile, "{} {} ", v1num[2], v2num[2]);
-		if (g->systems)
-			e->segment->write_label(travelfile, g->systems);
-		else	travelfile << e->segment_name;
-		travelfile << ' ' << (travnum ? e->segment->clinchedby_code(cbycode, threadnum) : "0");
-		for (HGVertex *intermediate : e->intermediate_points)
-			travelfile << intermediate->coordstr;
+	  if (e->format & formats & HGEdge::traveled)
+	  {	const char* code = travnum ? e->segment->clinchedby_code(cbycode, &traveler_set) : "0";
+		travelfile << v1num[2] << ' ' << v2num[2] << ' ';
+		travelfile << *label;
+		travelfile << ' ' << code;
+		for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+			travelfile.write((*ip)->coordstr(), (*ip)->coord_len);
 		travelfile << '\n';
+		if (travelbin)
+		{	travelbin->edge(v1num[2], v2num[2], *label);
+			travelbin->clinched_by(code);
+			for (HGVertex **ip = e->ip_begin(), **end = e->ip_end(); ip != end; ++ip)
+				travelbin->point((*ip)->lat, (*ip)->lng);
+		}
+		if (travelstats) travelstats->edge(v1num[2], v2num[2]);
 	  }
 	}
 	delete[] cbycode;
 
 	// traveler names
 	for (TravelerList *t : traveler_lists)
-		travelfile << t->traveler_name << ' ';
+	{	travelfile << t->traveler_name << ' ';
+		if (travelbin) travelbin->traveler(t->traveler_name);
+	}
 	travelfile << '\n';
 	simplefile.close();
 	collapfile.close();
 	travelfile.close();
-	if (g->regions) delete g->regions;
-	if (g->systems) delete g->systems;
-	if (g->placeradius) delete g->placeradius;
+	if (simplebin) {simplebin->write(Args::graphfilepath+'/'+g -> stem()+".tmgb"); delete simplebin;}
+	if (collapbin) {collapbin->write(Args::graphfilepath+'/'+g[1].stem()+".tmgb"); delete collapbin;}
+	if (travelbin) {travelbin->write(Args::graphfilepath+'/'+g[2].stem()+".tmgb"); delete travelbin;}
+	if (simplestats) simplestats->finish();
+	if (collapstats) collapstats->finish();
+	if (travelstats) travelstats->finish();
 
-	g -> vertices = sv_count; g -> edges = se_count; g -> travelers = 0;
-	g[1].vertices = cv_count; g[1].edges = ce_count; g[1].travelers = 0;
-	g[2].vertices = tv_count; g[2].edges = te_count; g[2].travelers = travnum;
+	if (formats & HGEdge::simple)	 {g -> vertices = sv_count; g -> edges = se_count; g -> travelers = 0;}
+	if (formats & HGEdge::collapsed) {g[1].vertices = cv_count; g[1].edges = ce_count; g[1].travelers = 0;}
+	if (formats & HGEdge::traveled)	 {g[2].vertices = tv_count; g[2].edges = te_count; g[2].travelers = travnum;}
+
+	if (formats & HGEdge::intonly)
+	{	std::vector<HGVertex*> cverts;
+		std::vector<HGEdge*> cedges;
+		std::vector<uint32_t> ends;
+		for (HGVertex* v : vlist)
+		  if (v->visibility == 2) cverts.push_back(v);
+		for (HGEdge* e : elist)
+		  if (e->format & HGEdge::collapsed)
+		  {	cedges.push_back(e);
+			ends.push_back(vnums[mv.rank(vrank, e->vertex1)*3+1]);
+			ends.push_back(vnums[mv.rank(vrank, e->vertex2)*3+1]);
+		  }
+		write_intonly_tmg(g+1, cverts, cedges, ends);
+	}
+}
+
+// Write the intersection-only counterpart of a collapsed graph, in which
+// every vertex with exactly 2 edges is collapsed as hidden vertices are,
+// its coordinates becoming a shaping point of 1 edge joining them.
+// A cycle of such vertices keeps its 1st vertex, at which it's a loop.
+// Labels of the edges joined are joined with ':', skipping any that
+// repeat the previous one. cverts & cedges are the collapsed graph's
+// vertices & edges in file order, and ends its edges' endpoints' vertex
+// numbers, 2 per edge.
+void HighwayGraph::write_intonly_tmg
+(	GraphListEntry* g, std::vector<HGVertex*>& cverts, std::vector<HGEdge*>& cedges, std::vector<uint32_t>& ends
+)
+{	uint32_t const nv = cverts.size();
+	uint32_t const ne = cedges.size();
+	// degree of each vertex & its first 2 edges
+	std::vector<uint32_t> degree(nv, 0);
+	std::vector<uint32_t> inc(2*nv);
+	for (uint32_t e = 0; e < ne; e++)
+	  for (int i = 0; i < 2; i++)
+	  {	uint32_t const v = ends[2*e+i];
+		if (degree[v] < 2) inc[2*v+degree[v]] = e;
+		degree[v]++;
+	  }
+	// the vertex at the other end of edge e from v, & the other edge at v
+	auto other_vertex = [&](uint32_t e, uint32_t v) {return ends[2*e] == v ? ends[2*e+1] : ends[2*e];};
+	auto other_edge   = [&](uint32_t v, uint32_t e) {return inc[2*v] == e ? inc[2*v+1] : inc[2*v];};
+
+	// keep vertices of any other degree, & those whose 2 ends are of 1 loop
+	std::vector<char> keep(nv);
+	for (uint32_t v = 0; v < nv; v++)
+		keep[v] = degree[v] != 2 || inc[2*v] == inc[2*v+1];
+	// walk each chain of the rest both ways to its ends; if the
+	// 1st way leads back where it started, it's a cycle
+	std::vector<char> seen(nv, 0);
+	for (uint32_t v = 0; v < nv; v++)
+	  if (!keep[v] && !seen[v])
+	    for (int i = 0; i < 2; i++)
+	    {	uint32_t e = inc[2*v+i];
+		uint32_t u = other_vertex(e, v);
+		while (!keep[u] && u != v)
+		{	seen[u] = 1;
+			e = other_edge(u, e);
+			u = other_vertex(e, u);
+		}
+		if (u == v)
+		{	keep[v] = 1;
+			break;
+		}
+	    }
+	std::vector<char>().swap(seen);
+	uint32_t kv = 0;
+	for (uint32_t v = 0; v < nv; v++) kv += keep[v];
+	std::vector<uint32_t> vnum(nv);
+	for (uint32_t v = 0, n = 0; v < nv; v++)
+	  if (keep[v]) vnum[v] = n++;
+
+	TMGWriter file(Args::graphfilepath+'/'+g->intonly_filename());
+	TMGBBuilder* bin = Args::binarygraphs ? new TMGBBuilder(TMGB_COLLAPSED, 0) : 0;
+						    // deleted once written
+	GraphStats* stats = Args::graphstats ? &g->intonly_stats : 0;
+	// each vertex collapsed removes 1 edge
+	file << "TMG 1.0 collapsed\n" << kv << ' ' << ne-(nv-kv) << '\n';
+	for (uint32_t v = 0; v < nv; v++)
+	  if (keep[v])
+	  {	HGVertex* cv = cverts[v];
+		(file << cv->unique_name).write(cv->coordstr(), cv->coord_len) << '\n';
+		if (bin) bin->vertex(cv->unique_name, cv->lat, cv->lng);
+		if (stats) stats->vertex(cv->lat, cv->lng);
+	  }
+
+	// write edges, each walked from a kept end, in order of its 1st collapsed edge
+	std::vector<char> used(ne, 0);
+	std::vector<HGVertex*> points;
+	std::string label, syslabel;
+	for (uint32_t e = 0; e < ne; e++)
+	{	if (used[e]) continue;
+		uint32_t v = ends[2*e];
+		if (!keep[v] && !keep[v = ends[2*e+1]]) continue;
+		uint32_t const v1 = v;
+		size_t last = 0; // where the last label joined begins
+		label.clear();
+		points.clear();
+		for (uint32_t f = e;; f = other_edge(v, f))
+		{	used[f] = 1;
+			HGEdge* ce = cedges[f];
+			const std::string* l = &ce->segment_name();
+			if (g->systems)
+			{	syslabel.clear();
+				ce->segment->write_label(syslabel, g->systems);
+				l = &syslabel;
+			}
+			if (f == e) label = *l;
+			else if (label.compare(last, std::string::npos, *l))
+			     {	last = label.size()+1;
+				label += ':';
+				label += *l;
+			     }
+			// shaping points, in the direction walked
+			if (ends[2*f] == v)
+				points.insert(points.end(), ce->ip_begin(), ce->ip_end());
+			else	points.insert(points.end(), std::reverse_iterator<HGVertex**>(ce->ip_end()),
+							    std::reverse_iterator<HGVertex**>(ce->ip_begin()));
+			v = other_vertex(f, v);
+			if (keep[v]) break;
+			points.push_back(cverts[v]);
+		}
+		file << vnum[v1] << ' ' << vnum[v] << ' ' << label;
+		for (HGVertex* p : points) file.write(p->coordstr(), p->coord_len);
+		file << '\n';
+		if (bin)
+		{	bin->edge(vnum[v1], vnum[v], label);
+			for (HGVertex* p : points) bin->point(p->lat, p->lng);
+		}
+		if (stats) stats->edge(vnum[v1], vnum[v]);
+	}
+	file.close();
+	if (bin)
+	{	bin->write(Args::graphfilepath+'/'+g->stem()+"-intonly.tmgb");
+		delete bin;
+	}
+	if (stats) stats->finish();
 }
@@ -3,10 +3,17 @@ class GraphListEntry;
 class HGEdge;
 class HGVertex;
 class HighwaySystem;
+class PlaceRadius;
+class Region;
 class TravelerList;
 class Waypoint;
 class WaypointQuadtree;
+#include "HGCSR.h"
+#include "VertexNameSet.h"
 #include "../../templates/TMArray.cpp"
+#include "../../templates/TMBitset.cpp"
+#include <atomic>
+#include <condition_variable>
 #include <list>
 #include <mutex>
 #include <unordered_map>
@@ -25,24 +32,57 @@ class HighwayGraph
       - in the collapsed graph with hidden waypoints compressed into multi-point edges
       - in the traveled graph: collapsed edges split at endpoints of users' travels
       - in no graph at all for temporary partially-collapsed edges created
-	during the compression process. These stick around taking up
-	space until the HighwayGraph object is destroyed. Mostly harmless.
+	during the compression process. These are released as soon as
+	they're collapsed into another edge, keeping only their slot in
+	the edges array. Intermediate points are stored only for live
+	edges, in HGEdge::ip_arena, once compression is complete.
     */
 
 	public:
-	std::unordered_set<std::string> vertex_names[256];	// unique vertex labels
+	VertexNameSet vertex_names;				// unique vertex labels
 	std::list<std::string> waypoint_naming_log;		// to track waypoint name compressions
-	std::mutex set_mtx[256], log_mtx;
+	std::mutex log_mtx;
 	std::vector<HGVertex> vertices;				// MUST be stored
 	TMArray<HGEdge> edges;					// sequentially!
 	unsigned int cv, tv, se, ce, te;			// vertex & edge counts
 
+	struct VESets
+	{	TMBitset<HGVertex*, uint64_t> mv;
+		TMBitset<HGEdge*,   uint64_t> me;
+		std::vector<Region*> regions;		// whose sets are unioned in, with those of parts
+		std::vector<HighwaySystem*> systems;	// whose sets are unioned in, with those of parts
+		std::vector<VESets*> parts;		// other entries unioned, or intersected, in
+		PlaceRadius* placeradius;		// whose sets are intersected with those of parts
+		bool intersection;
+		char state;		// 0 = not yet computed, 1 = being computed, 2 = ready
+		unsigned int users;	// subgraphs & other entries yet to use these
+		VESets(): placeradius(0), intersection(0), state(0), users(0) {}
+		void take(TMBitset<HGVertex*, uint64_t>&, TMBitset<HGEdge*, uint64_t>&);
+	};
+	std::unordered_map<std::string, VESets> ve_cache;	// subgraph vertex & edge sets by selection criteria
+	std::mutex ve_mtx;
+	std::condition_variable ve_cv;				// signals VESets becoming ready
+	HGCSR csr[3];						// master graph adjacency per format, while dumped for -A
+
 	HighwayGraph(WaypointQuadtree&, ElapsedTime&);
+	~HighwayGraph();
 
 	void namelog(std::string&&);
 	void simplify(int, std::vector<std::pair<Waypoint*,size_t>>*, unsigned int*);
+	void set_visibility(int);
+	void find_chains(int, unsigned int*, std::vector<HGVertex*>*);
+	void chain(HGVertex*, HGEdge*, unsigned int*, std::vector<HGVertex*>&);
+	void compress(int, unsigned int*, std::vector<HGVertex*>*);
+	void sort_ve_edges(int, std::atomic_uint*, HGEdge**);
 	void bitsetlogs(HGVertex*);
-	inline std::pair<std::unordered_set<std::string>::iterator,bool> vertex_name(std::string&);
-	void write_master_graphs_tmg();
-	void write_subgraphs_tmg(size_t, unsigned int, WaypointQuadtree*, ElapsedTime*, std::mutex*);
+	void build_csr();
+	void write_master_graphs_tmg(unsigned char);
+	static std::string ve_key(GraphListEntry*);
+	VESets* ve_regions(std::vector<Region*>);
+	VESets* ve_systems(std::vector<HighwaySystem*>);
+	void ve_expect(size_t);
+	void ve_make(VESets&, WaypointQuadtree*);
+	void ve_sets(GraphListEntry*, WaypointQuadtree*, TMBitset<HGVertex*, uint64_t>&, TMBitset<HGEdge*, uint64_t>&);
+	void write_subgraphs_tmg(size_t, unsigned char, WaypointQuadtree*, ElapsedTime*, std::mutex*);
+	void write_intonly_tmg(GraphListEntry*, std::vector<HGVertex*>&, std::vector<HGEdge*>&, std::vector<uint32_t>&);
 };
@@ -6,15 +6,93 @@
 #include "../Waypoint/Waypoint.h"
 #include "../WaypointQuadtree/WaypointQuadtree.h"
 #include <cmath>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 #define pi 3.141592653589793238
 
+std::vector<HGVertex*> PlaceRadius::leaf_v;
+std::vector<double> PlaceRadius::leaf_x, PlaceRadius::leaf_y, PlaceRadius::leaf_z;
+unsigned int PlaceRadius::max_leaf = 0;
+
 PlaceRadius::PlaceRadius(const char *D, const char *T, double& Y, double& X, double& R)
 {	descr = D;
 	title = T;
 	lat = Y;
 	lng = X;
 	r = R;
+	x = cos(lat*(pi/180)) * cos(lng*(pi/180));
+	y = cos(lat*(pi/180)) * sin(lng*(pi/180));
+	z = sin(lat*(pi/180));
+	// The dot product of two unit vectors is the cosine of the angle between them,
+	// the same quantity contains_vertex takes the acos of. Leave a margin for rounding,
+	// & have contains_vertex decide the few vertices within it, for identical results.
+	cos_lo = cos(r/3963.1) - 1e-12;
+	cos_hi = cos(r/3963.1) + 1e-12;
+}
+
+void PlaceRadius::setup(WaypointQuadtree *qt)
+{	// group graph vertices by quadtree terminal node, with their unit vectors
+	// & each node's latitude range, to search a whole node's vertices at once
+	if (qt->refined())
+	{	setup(qt->nw_child);
+		setup(qt->ne_child);
+		setup(qt->sw_child);
+		setup(qt->se_child);
+		return;
+	}
+	qt->v_begin = leaf_v.size();
+	qt->v_min_lat =  HUGE_VAL;
+	qt->v_max_lat = -HUGE_VAL;
+	for (Waypoint *p : qt->points)
+	  if ((!p->colocated || p == p->colocated->front()) && p->is_or_colocated_with_active_or_preview())
+	  {	leaf_v.push_back(p->vertex);
+		leaf_x.push_back(cos(p->lat*(pi/180)) * cos(p->lng*(pi/180)));
+		leaf_y.push_back(cos(p->lat*(pi/180)) * sin(p->lng*(pi/180)));
+		leaf_z.push_back(sin(p->lat*(pi/180)));
+		if (p->lat < qt->v_min_lat) qt->v_min_lat = p->lat;
+		if (p->lat > qt->v_max_lat) qt->v_max_lat = p->lat;
+	  }
+	qt->v_end = leaf_v.size();
+	if (qt->v_end - qt->v_begin > max_leaf) max_leaf = qt->v_end - qt->v_begin;
+}
+
+void PlaceRadius::clear()
+{	std::vector<HGVertex*>().swap(leaf_v);
+	std::vector<double>().swap(leaf_x);
+	std::vector<double>().swap(leaf_y);
+	std::vector<double>().swap(leaf_z);
+}
+
+// Write to out the indices in [b, e) of unit vectors whose dot products
+// with (cx, cy, cz) are >= lo; return how many.
+static size_t near_scalar(size_t b, size_t e, double cx, double cy, double cz, double lo, uint32_t* out)
+{	const double *x = PlaceRadius::leaf_x.data(), *y = PlaceRadius::leaf_y.data(), *z = PlaceRadius::leaf_z.data();
+	size_t n = 0;
+	for (size_t i = b; i < e; ++i)
+	  if (cx*x[i] + cy*y[i] + cz*z[i] >= lo) out[n++] = i;
+	return n;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("avx2"))) static size_t near_avx2(size_t b, size_t e, double cx, double cy, double cz, double lo, uint32_t* out)
+{	const double *x = PlaceRadius::leaf_x.data(), *y = PlaceRadius::leaf_y.data(), *z = PlaceRadius::leaf_z.data();
+	const __m256d vx = _mm256_set1_pd(cx), vy = _mm256_set1_pd(cy), vz = _mm256_set1_pd(cz), vlo = _mm256_set1_pd(lo);
+	size_t n = 0, i = b;
+	for (; i+4 <= e; i += 4)
+	{	__m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vx, _mm256_loadu_pd(x+i)),
+							_mm256_mul_pd(vy, _mm256_loadu_pd(y+i))),
+							_mm256_mul_pd(vz, _mm256_loadu_pd(z+i)));
+		for (int m = _mm256_movemask_pd(_mm256_cmp_pd(d, vlo, _CMP_GE_OQ)); m; m &= m-1)
+			out[n++] = i + __builtin_ctz(m);
+	}
+	return n + near_scalar(i, e, cx, cy, cz, lo, out+n);
 }
+static size_t (*near)(size_t, size_t, double, double, double, double, uint32_t*)
+	= (__builtin_cpu_init(), __builtin_cpu_supports("avx2")) ? near_avx2 : near_scalar;
+#else
+static size_t (*near)(size_t, size_t, double, double, double, double, uint32_t*) = near_scalar;
+#endif
 
 bool PlaceRadius::contains_vertex(double vlat, double vlng)
 {	/* return whether coordinates are within this area */
@@ -50,34 +128,46 @@ void PlaceRadius::matching_ve(TMBitset<HGVertex*,uint64_t>& mv, TMBitset<HGEdge*
 	// This function handles setup & sanity checks, passing control over
 	// to the recursive ve_search function to do the actual searching.
 
+	// vertices found, & scratch space for ve_search
+	std::vector<HGVertex*> found;
+	std::vector<uint32_t> near_v(max_leaf);
+
 	// N/S sanity check: If lat is <= r/2 miles to the N or S pole, lngdelta calculation will fail.
 	// In these cases, our place radius will span the entire "width" of the world, from -180 to +180 degrees.
-	if (90-fabs(lat)*(pi/180) <= r/7926.2) return ve_search(mv, me, qt, -180, +180);
-
-	// width, in degrees longitude, of our bounding box for quadtree search
-	double lngdelta = acos((cos(r/3963.1) - pow(sin(lat*(pi/180)),2)) / pow(cos(lat*(pi/180)),2)) / (pi/180);
-	double w_bound = lng-lngdelta;
-	double e_bound = lng+lngdelta;
-
-	// normal operation; search quadtree within calculated bounds
-	ve_search(mv, me, qt, w_bound, e_bound);
-
-	// If bounding box spans international date line to west of -180 degrees,
-	// search quadtree within the corresponding range of positive longitudes
-	if (w_bound <= -180)
-	{	do w_bound += 360; while (w_bound <= -180);
-		ve_search(mv, me, qt, w_bound, 180);
-	}
+	if (90-fabs(lat)*(pi/180) <= r/7926.2) ve_search(mv, found, near_v.data(), qt, -180, +180);
+	else {
+
+		// width, in degrees longitude, of our bounding box for quadtree search
+		double lngdelta = acos((cos(r/3963.1) - pow(sin(lat*(pi/180)),2)) / pow(cos(lat*(pi/180)),2)) / (pi/180);
+		double w_bound = lng-lngdelta;
+		double e_bound = lng+lngdelta;
+
+		// normal operation; search quadtree within calculated bounds
+		ve_search(mv, found, near_v.data(), qt, w_bound, e_bound);
+
+		// If bounding box spans international date line to west of -180 degrees,
+		// search quadtree within the corresponding range of positive longitudes
+		if (w_bound <= -180)
+		{	do w_bound += 360; while (w_bound <= -180);
+			ve_search(mv, found, near_v.data(), qt, w_bound, 180);
+		}
+
+		// If bounding box spans international date line to east of +180 degrees,
+		// search quadtree within the corresponding range of negative longitudes
+		if (e_bound >= 180)
+		{	do e_bound -= 360; while (e_bound >= 180);
+			ve_search(mv, found, near_v.data(), qt, -180, e_bound);
+		}
+	     }
 
-	// If bounding box spans international date line to east of +180 degrees,
-	// search quadtree within the corresponding range of negative longitudes
-	if (e_bound >= 180)
-	{	do e_bound -= 360; while (e_bound >= 180);
-		ve_search(mv, me, qt, -180, e_bound);
-	}
+	// edges with both vertices within the area
+	for (HGVertex* v : found)
+	  for (HGEdge* e : v->incident_edges)
+	    if (mv.has_value(v == e->vertex1 ? e->vertex2 : e->vertex1))
+	      me.add_value(e);
 }
 
-void PlaceRadius::ve_search(TMBitset<HGVertex*,uint64_t>& mv, TMBitset<HGEdge*,uint64_t>& me,
+void PlaceRadius::ve_search(TMBitset<HGVertex*,uint64_t>& mv, std::vector<HGVertex*>& found, uint32_t* near_v,
 			    WaypointQuadtree *qt, double w_bound, double e_bound)
 {	// recursively search quadtree for waypoints within this PlaceRadius
 	// area, and populate a set of their corresponding graph vertices
@@ -85,18 +175,16 @@ void PlaceRadius::ve_search(TMBitset<HGVertex*,uint64_t>& mv, TMBitset<HGEdge*,u
 	// first check if this is a terminal quadrant, and if it is,
 	// we search for vertices within this quadrant
 	if (!qt->refined())
-	{	for (Waypoint *p : qt->points)
-		  if (	(!p->colocated || p == p->colocated->front())
-		  &&	p->is_or_colocated_with_active_or_preview()
-		  &&	contains_vertex(p->lat, p->lng)
-		     ){	HGVertex* v = p->vertex;
-			mv.add_value(v);
-			for (HGEdge* e : v->incident_edges)
-			{	HGVertex* v2 = v == e->vertex1 ? e->vertex2 : e->vertex1;
-				if (contains_vertex(v2->lat, v2->lng))
-				  me.add_value(e);
-			}
-		      }
+	{	// skip it if its vertices are all too far N or S
+		double lat_delta = r/3963.1/(pi/180) + 1e-9;
+		if (qt->v_max_lat < lat-lat_delta || qt->v_min_lat > lat+lat_delta) return;
+		const double *vx = leaf_x.data(), *vy = leaf_y.data(), *vz = leaf_z.data();
+		for (uint32_t *i = near_v, *end = i + near(qt->v_begin, qt->v_end, x, y, z, cos_lo, near_v); i < end; ++i)
+		{	HGVertex* v = leaf_v[*i];
+			if (	(x*vx[*i] + y*vy[*i] + z*vz[*i] > cos_hi || contains_vertex(v->lat, v->lng))
+			&&	mv.add_value(v)
+			   )	found.push_back(v);
+		}
 	}
 	// if we're not a terminal quadrant, we need to determine which
 	// of our child quadrants we need to search and recurse into each
@@ -107,10 +195,10 @@ void PlaceRadius::ve_search(TMBitset<HGVertex*,uint64_t>& mv, TMBitset<HGEdge*,u
 		bool look_w = w_bound <= qt->mid_lng;
 		//std::cout << "DEBUG: recursive case, " << look_n << " " << look_s << " " << look_e << " " << look_w << std::endl;
 		// now look in the appropriate child quadrants
-		if (look_n && look_w)	ve_search(mv, me, qt->nw_child, w_bound, e_bound);
-		if (look_n && look_e)	ve_search(mv, me, qt->ne_child, w_bound, e_bound);
-		if (look_s && look_w)	ve_search(mv, me, qt->sw_child, w_bound, e_bound);
-		if (look_s && look_e)	ve_search(mv, me, qt->se_child, w_bound, e_bound);
+		if (look_n && look_w)	ve_search(mv, found, near_v, qt->nw_child, w_bound, e_bound);
+		if (look_n && look_e)	ve_search(mv, found, near_v, qt->ne_child, w_bound, e_bound);
+		if (look_s && look_w)	ve_search(mv, found, near_v, qt->sw_child, w_bound, e_bound);
+		if (look_s && look_e)	ve_search(mv, found, near_v, qt->se_child, w_bound, e_bound);
 	     }
 }
 
@@ -18,10 +18,19 @@ class PlaceRadius
 	std::string title;	// filename title, short name for area, E.G. "nyc"
 	double lat, lng;	// center latitude, longitude
 	double r;		// radius in miles
+	double x, y, z;		// center as a unit vector
+	double cos_lo, cos_hi;	// vertices' dot products with it below cos_lo are outside; above cos_hi, inside
+
+	// graph vertices grouped by quadtree terminal node, and their unit vectors
+	static std::vector<HGVertex*> leaf_v;
+	static std::vector<double> leaf_x, leaf_y, leaf_z;
+	static unsigned int max_leaf;
 
 	PlaceRadius(const char *, const char *, double &, double &, double &);
 
+	static void setup(WaypointQuadtree*);
+	static void clear();
 	bool contains_vertex(double, double);
 	void matching_ve(TMBitset<HGVertex*,uint64_t>&, TMBitset<HGEdge*,uint64_t>&, WaypointQuadtree*);
-	void   ve_search(TMBitset<HGVertex*,uint64_t>&, TMBitset<HGEdge*,uint64_t>&, WaypointQuadtree*, double, double);
+	void   ve_search(TMBitset<HGVertex*,uint64_t>&, std::vector<HGVertex*>&, uint32_t*, WaypointQuadtree*, double, double);
 };
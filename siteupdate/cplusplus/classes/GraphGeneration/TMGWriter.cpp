@@ -0,0 +1,286 @@
+#include "TMGWriter.h"
+#include "../Args/Args.h"
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+const char TMGWriter::digit_pairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+std::unordered_map<std::string, TMGWriter::FileInfo> TMGWriter::prev_manifest, TMGWriter::manifest;
+std::mutex TMGWriter::manifest_mtx;
+time_t TMGWriter::manifest_time;
+unsigned int TMGWriter::unchanged = 0;
+
+TMGWriter::TMGWriter(): zs(0), zbuf(0), active(0), prev_info(0), prev(0), pbuf(0)
+{	file.rdbuf()->pubsetbuf(0, 0); // we do our own buffering
+	pos = buf = new char[bufsize];
+		    // deleted by ~TMGWriter
+	end = buf + bufsize;
+}
+
+TMGWriter::TMGWriter(const std::string& filename): TMGWriter()
+{	open(filename);
+}
+
+void TMGWriter::open(const std::string& filename)
+{	path = filename;
+	active = 1;
+	if (Args::prevgraphpath.empty()) return open_file();
+	h = tail = size = 0;
+	tail_len = 0;
+	// hold text for comparison against the previous run's copy, if it has one
+	auto p = prev_manifest.find(path.substr(path.find_last_of('/')+1));
+	if (p == prev_manifest.end()) return open_file();
+	prev_info = &p->second;
+}
+
+void TMGWriter::open_file()
+{	// don't write thru a link to a previous run's file
+	if (!Args::prevgraphpath.empty()) unlink(path.data());
+	file.open(path, Args::gzipgraphs ? std::ios::out | std::ios::binary : std::ios::out);
+	if (!Args::gzipgraphs || !file.is_open()) return;
+	zs = new z_stream();
+	   // deleted by close
+	zbuf = new char[bufsize];
+	     // deleted by close
+	// 15 window bits, +16 for a gzip header & trailer
+	deflateInit2(zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY);
+}
+
+TMGWriter::~TMGWriter()
+{	close();
+	delete[] buf;
+}
+
+// compress whatever input zs has pending, writing all output produced
+void TMGWriter::deflate_to_file(int mode)
+{	do {	zs->next_out = (Bytef*)zbuf;
+		zs->avail_out = bufsize;
+		deflate(zs, mode);
+		file.write(zbuf, bufsize - zs->avail_out);
+	   } while (!zs->avail_out);
+}
+
+// send text to the file, compressed or not
+void TMGWriter::emit(const char* s, size_t size)
+{	if (!zs)
+	{	file.write(s, size);
+		return;
+	}
+	zs->next_in = (Bytef*)s;
+	zs->avail_in = size;
+	deflate_to_file(Z_NO_FLUSH);
+}
+
+// Too much to hold. Open prev, & see if what's held matches its start.
+bool TMGWriter::compare_prev()
+{	if (!(prev = gzopen((Args::prevgraphpath+path.substr(path.find_last_of('/'))).data(), "rb")))
+		return 0;
+	gzbuffer(prev, bufsize);
+	pbuf = new char[bufsize];
+	     // deleted by release_prev
+	if (!matches_prev(held.data(), held.size())) return 0;
+	std::string().swap(held);
+	return 1;
+}
+
+// read the next size bytes of prev, & see if they match s
+bool TMGWriter::matches_prev(const char* s, size_t size)
+{	while (size)
+	{	unsigned int const n = size < bufsize ? size : size_t(bufsize);
+		if (gzread(prev, pbuf, n) != int(n) || memcmp(s, pbuf, n)) return 0;
+		s += n;
+		size -= n;
+	}
+	return 1;
+}
+
+// Text can no longer match prev. Open the file, write what's held, or
+// else copy the part that matched from prev (everything hashed so far),
+// & stop comparing. Reading prev still works if opening the file unlinked it.
+void TMGWriter::diverge()
+{	open_file();
+	if (held.size()) emit(held.data(), held.size());
+	else if (prev)
+	{	gzrewind(prev);
+		for (uint64_t left = size; left;)
+		{	int const n = gzread(prev, pbuf, left < bufsize ? left : uint64_t(bufsize));
+			if (n <= 0) break;
+			emit(pbuf, n);
+			left -= n;
+		}
+	}
+	release_prev();
+}
+
+void TMGWriter::release_prev()
+{	if (prev) gzclose(prev);
+	delete[] pbuf;
+	std::string().swap(held);
+	prev_info = 0;
+	prev = 0;
+	pbuf = 0;
+}
+
+// hold text or compare it against prev, or send it to the file, & hash it
+void TMGWriter::put(const char* s, size_t n)
+{	if (!active) return;
+	if (prev_info)
+	{	if (size + n > prev_info->size) diverge(); // longer than prev; can't match
+		else if (prev) {if (!matches_prev(s, n)) diverge();}
+		else if (held.size() + n <= holdmax) held.append(s, n);
+		else if (!compare_prev() || !matches_prev(s, n)) diverge();
+	}
+	if (!prev_info) emit(s, n);
+	if (!Args::prevgraphpath.empty()) hash(s, n);
+}
+
+void TMGWriter::flush()
+{	put(buf, pos-buf);
+	pos = buf;
+}
+
+void TMGWriter::close()
+{	if (!active) return;
+	flush();
+	active = 0;
+	if (!Args::prevgraphpath.empty())
+	{	std::string name = path.substr(path.find_last_of('/')+1);
+		FileInfo info = {size, digest()};
+		bool same = 0;
+		if (prev_info)
+		{	char c;
+			if (prev) // all text read back matched; so must the end of the file
+				same = !gzread(prev, &c, 1) && link_prev(name);
+			else	same = size == prev_info->size && info.hash == prev_info->hash && link_prev(name);
+			if (!same) diverge();
+			else release_prev();
+		}
+		manifest_mtx.lock();
+		manifest[name] = info;
+		unchanged += same;
+		manifest_mtx.unlock();
+	}
+	if (!file.is_open()) return;
+	if (zs)
+	{	deflate_to_file(Z_FINISH);
+		deflateEnd(zs);
+		delete zs;
+		delete[] zbuf;
+		zs = 0;
+		zbuf = 0;
+	}
+	file.close();
+}
+
+TMGWriter& TMGWriter::write(const char* s, size_t size)
+{	if (size > size_t(end-pos))
+	{	flush();
+		// too big to buffer; write it straight through
+		if (size > bufsize)
+		{	put(s, size);
+			return *this;
+		}
+	}
+	memcpy(pos, s, size);
+	pos += size;
+	return *this;
+}
+
+TMGWriter& TMGWriter::operator << (unsigned long n)
+{	char digits[20];
+	char* d = digits+20;
+	while (n >= 100)
+	{	d -= 2;
+		memcpy(d, digit_pairs + n%100*2, 2);
+		n /= 100;
+	}
+	if (n >= 10)
+	{	d -= 2;
+		memcpy(d, digit_pairs + n*2, 2);
+	}
+	else	*--d = '0' + n;
+	return write(d, digits+20-d);
+}
+
+// content hashing & manifests
+
+static uint64_t mix(uint64_t h, uint64_t w)
+{	h ^= w * 0xC2B2AE3D27D4EB4Full;
+	return (h << 31 | h >> 33) * 0x9E3779B185EBCA87ull;
+}
+
+// Hash a word at a time, carrying any partial word over to the next call,
+// so the result doesn't depend on how the text was split up between calls.
+void TMGWriter::hash(const char* s, size_t n)
+{	size += n;
+	if (tail_len)
+	{	for (; tail_len < 8 && n; --n) tail |= uint64_t(uint8_t(*s++)) << 8*tail_len++;
+		if (tail_len < 8) return;
+		h = mix(h, tail);
+		tail = tail_len = 0;
+	}
+	for (; n >= 8; s += 8, n -= 8)
+	{	uint64_t w;
+		memcpy(&w, s, 8);
+		h = mix(h, w);
+	}
+	for (; n; --n) tail |= uint64_t(uint8_t(*s++)) << 8*tail_len++;
+}
+
+uint64_t TMGWriter::digest()
+{	uint64_t d = mix(mix(h, tail), size);
+	d ^= d >> 33; d *= 0xC2B2AE3D27D4EB4Full;
+	d ^= d >> 29; d *= 0x165667B19E3779F9ull;
+	return d ^ d >> 32;
+}
+
+// Put the previous run's copy of a file in place, if it still exists,
+// & hasn't been modified since its manifest was written.
+bool TMGWriter::link_prev(const std::string& name)
+{	std::string prev = Args::prevgraphpath+'/'+name;
+	struct stat p, n;
+	if (stat(prev.data(), &p) || p.st_mtime > manifest_time) return 0;
+	if (!stat(path.data(), &n) && p.st_dev == n.st_dev && p.st_ino == n.st_ino)
+		return 1; // already here; same graph directory as last time
+	unlink(path.data());
+	return !link(prev.data(), path.data());
+}
+
+// Read graphs.manifest from the previous run's graph directory, if there.
+// Each line is a file name, its size before any compression & its hash.
+void TMGWriter::read_manifest()
+{	std::string path = Args::prevgraphpath + "/graphs.manifest";
+	struct stat m;
+	if (stat(path.data(), &m)) return;
+	manifest_time = m.st_mtime;
+	std::ifstream in(path);
+	std::string name;
+	FileInfo info;
+	while (std::getline(in, name, ';') && in >> info.size && in.ignore() && in >> std::hex >> info.hash >> std::dec)
+	{	prev_manifest[name] = info;
+		in.ignore();
+	}
+}
+
+void TMGWriter::write_manifest()
+{	std::vector<std::pair<std::string, FileInfo>> files(manifest.begin(), manifest.end());
+	std::sort(files.begin(), files.end(), [](const std::pair<std::string, FileInfo>& a, const std::pair<std::string, FileInfo>& b)
+						{return a.first < b.first;});
+	std::ofstream out(Args::graphfilepath + "/graphs.manifest");
+	for (auto& f : files)
+		out << f.first << ';' << f.second.size << ';' << std::hex << f.second.hash << std::dec << '\n';
+	prev_manifest.clear();
+	manifest.clear();
+}
@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <zlib.h>
+
+class TMGWriter
+{   /* Output for one .tmg file. Text is formatted into a large
+    buffer, and written to disk in big sequential chunks rather
+    than field by field. Integers, mostly vertex numbers, are
+    converted 2 digits at a time without going through the locale
+    machinery of std::ostream.
+    Text written to a TMGWriter that was never opened is discarded.
+    With Args::gzipgraphs, files are gzipped as they're written,
+    a buffer at a time, by the thread writing them.
+    With Args::prevgraphpath, text is hashed as it's written for
+    this run's manifest. If the previous run's manifest lists the
+    file, text is held in memory rather than written out, & if its
+    size & hash at the end match those listed, that run's copy is
+    hard-linked in its place. Past holdmax bytes, text is instead
+    compared against that copy, read back a buffer at a time.
+    Once the text can't match, by outgrowing the listed size or
+    differing from the copy, what's held or matched so far is
+    written out, & writing continues as normal.
+    */
+	static const size_t bufsize = 1 << 18;
+	static const size_t holdmax = 1 << 22;
+	static const char digit_pairs[201];
+
+	struct FileInfo {uint64_t size, hash;};
+	static std::unordered_map<std::string, FileInfo> prev_manifest, manifest;
+	static std::mutex manifest_mtx;
+	static time_t manifest_time;	// when the previous run's manifest was written
+
+	std::string path;
+	std::ofstream file;
+	char *buf, *pos, *end;
+	z_stream* zs;	// deflate stream, or 0 if uncompressed
+	char* zbuf;	// compressed output
+	bool active;	// opened, & not yet closed
+	const FileInfo* prev_info;	// previous run's manifest entry, while text can match it; else 0
+	std::string held;		// text so far, while not yet compared against prev
+	gzFile prev;	// previous run's copy, once text is compared against it; else 0
+	char* pbuf;	// text read back from prev
+	uint64_t h, tail, size;	// hash state: hash of whole words so far, bytes of partial word, & total bytes
+	unsigned int tail_len;
+
+	void open_file();
+	void flush();
+	void put(const char*, size_t);
+	void emit(const char*, size_t);
+	void deflate_to_file(int);
+	bool compare_prev();
+	bool matches_prev(const char*, size_t);
+	void diverge();
+	void release_prev();
+	void hash(const char*, size_t);
+	uint64_t digest();
+	bool link_prev(const std::string&);
+
+	public:
+	static unsigned int unchanged;	// files linked from the previous run
+
+	static void read_manifest();
+	static void write_manifest();
+
+	TMGWriter();
+	TMGWriter(const std::string&);
+	~TMGWriter();
+
+	void open(const std::string&);
+	void close();
+	TMGWriter& write(const char*, size_t);
+
+	TMGWriter& operator << (char c)
+	{	if (pos == end) flush();
+		*pos++ = c;
+		return *this;
+	}
+	TMGWriter& operator << (const char* s)		{return write(s, strlen(s));}
+	TMGWriter& operator << (const std::string& s)	{return write(s.data(), s.size());}
+	TMGWriter& operator << (unsigned long);
+	TMGWriter& operator << (unsigned int n)		{return *this << (unsigned long)n;}
+	TMGWriter& operator << (int n)			{return *this << (unsigned long)n;} // never negative
+};
@@ -0,0 +1,73 @@
+#include "VertexNameSet.h"
+#include <cstdlib>
+#include <cstring>
+
+VertexNameSet::Shard::Shard(): slots(16), count(0), next(0), block_left(0) {}
+
+VertexNameSet::Shard::~Shard()
+{	for (char* b : blocks) free(b);
+}
+
+uint64_t VertexNameSet::hash(const std::string& name)
+{	// 64-bit FNV-1a
+	uint64_t h = 0xcbf29ce484222325;
+	for (unsigned char c : name)
+	{	h ^= c;
+		h *= 0x100000001b3;
+	}
+	return h;
+}
+
+std::pair<uint64_t, const char*>* VertexNameSet::Shard::find(uint64_t h, const char* name)
+{	// slot holding name, or the empty slot where it belongs
+	size_t mask = slots.size()-1;
+	for (size_t i = h & mask; ; i = (i+1) & mask)
+	{	std::pair<uint64_t, const char*>& s = slots[i];
+		if (!s.second || s.first == h && !strcmp(s.second, name)) return &s;
+	}
+}
+
+const char* VertexNameSet::Shard::store(const std::string& name)
+{	// copy name into the arena
+	size_t size = name.size()+1;
+	if (size > block_left)
+	{	block_left = size > block_size ? size : block_size;
+		blocks.push_back(next = (char*)malloc(block_left));
+	}
+	char* c = (char*)memcpy(next, name.data(), size);
+	next += size;
+	block_left -= size;
+	return c;
+}
+
+void VertexNameSet::Shard::grow()
+{	// double table size, keeping load factor <= 1/2
+	std::vector<std::pair<uint64_t, const char*>> old(slots.size()*2);
+	old.swap(slots);
+	size_t mask = slots.size()-1;
+	for (std::pair<uint64_t, const char*>& s : old)
+	  if (s.second)
+	  {	size_t i = s.first & mask;
+		while (slots[i].second) i = (i+1) & mask;
+		slots[i] = s;
+	  }
+}
+
+std::pair<const char*, bool> VertexNameSet::insert(const std::string& name)
+{	uint64_t h = hash(name);
+	Shard& shard = shards[h >> (64-shard_bits)];
+	std::lock_guard<std::mutex> lock(shard.mtx);
+	std::pair<uint64_t, const char*>* s = shard.find(h, name.data());
+	if (s->second) return std::make_pair(s->second, false);
+	const char* stored = shard.store(name);
+	*s = std::make_pair(h, stored);
+	if (++shard.count*2 > shard.slots.size()) shard.grow();
+	return std::make_pair(stored, true);
+}
+
+bool VertexNameSet::contains(const std::string& name)
+{	uint64_t h = hash(name);
+	Shard& shard = shards[h >> (64-shard_bits)];
+	std::lock_guard<std::mutex> lock(shard.mtx);
+	return shard.find(h, name.data())->second;
+}
@@ -0,0 +1,42 @@
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class VertexNameSet
+{   /* Set of unique vertex names, safe for concurrent insertion by
+    HighwayGraph::simplify threads.
+
+    Names are spread across lock-striped shards by a 64-bit FNV-1a
+    hash: the high bits select a shard, the low bits a starting slot
+    in that shard's linear-probing table. Each shard copies its names
+    into its own arena of large blocks, so no per-name allocation
+    is made, and the char pointers returned stay valid for the life
+    of the set, to be used as HGVertex::unique_name.
+    */
+	static const unsigned int shard_bits = 10;
+	static const size_t block_size = 1 << 16;
+
+	struct alignas(64) Shard
+	{	std::mutex mtx;
+		std::vector<std::pair<uint64_t, const char*>> slots; // hash & name; null name = empty slot
+		size_t count;
+		std::vector<char*> blocks;	// arena
+		char* next;
+		size_t block_left;
+
+		Shard();
+		~Shard();
+		std::pair<uint64_t, const char*>* find(uint64_t, const char*);
+		const char* store(const std::string&);
+		void grow();
+	};
+	Shard shards[1 << shard_bits];
+
+	static uint64_t hash(const std::string&);
+
+	public:
+	std::pair<const char*, bool> insert(const std::string&);
+	bool contains(const std::string&);
+};
@@ -83,37 +83,38 @@ std::string HighwaySegment::segment_name()
 	return "";
 }//*/
 
-const char* HighwaySegment::clinchedby_code(char* code, unsigned int threadnum)
+const char* HighwaySegment::clinchedby_code(char* code, const TMBitset<TravelerList*, uint32_t>* travelers)
 {	// Compute a hexadecimal string encoding which travelers
 	// have clinched this segment, for use in "traveled" graph files.
 	// Each character stores info for traveler #n thru traveler #n+3.
 	// The first character stores traveler 0 thru traveler 3,
 	// The second character stores traveler 4 thru traveler 7, etc.
 	// For each character, the low-order bit stores traveler n, and the high bit traveler n+3.
-
-	for (TravelerList* t : clinched_by)
-		code[t->traveler_num[threadnum]/4] += 1 << t->traveler_num[threadnum]%4;
-	for (char* nibble = code; *nibble; ++nibble) if (*nibble > '9') *nibble += 7;
+	// Travelers are numbered by their order in the graph's set of travelers,
+	// or in TravelerList::allusers if there's none. Either way, that's the
+	// order of their clinched_by bits, which are packed together & converted
+	// a word at a time, rather than traveler by traveler.
+	clinched_by.hex_code(code, travelers);
 	return code;
 }
 
 // write an edge label, restricted by systems
-void HighwaySegment::write_label(std::ofstream& file, std::vector<HighwaySystem*> *systems)
+void HighwaySegment::write_label(std::string& label, std::vector<HighwaySystem*> *systems)
 {	if (concurrent)
 	     {	bool write_comma = 0;
 		for (HighwaySegment* cs : *concurrent)
 		  // This function is only called when systems is nonzero. Safe to dereference.
 		  if ( !cs->route->system->devel() && contains(*systems, cs->route->system) )
-		  {	if  (write_comma) file << ',';
+		  {	if  (write_comma) label += ',';
 			else write_comma = 1;
-			file << cs->route->route;
-			file << cs->route->banner;
-			file << cs->route->abbrev;
+			label += cs->route->route;
+			label += cs->route->banner;
+			label += cs->route->abbrev;
 		  }
 	     }
-	else {	file << route->route;
-		file << route->banner;
-		file << route->abbrev;
+	else {	label += route->route;
+		label += route->banner;
+		label += route->abbrev;
 	     }
 }
 
@@ -5,6 +5,7 @@ class Waypoint;
 #include "../../templates/TMBitset.cpp"
 #include <list>
 #include <mutex>
+#include <string>
 #include <vector>
 
 class HighwaySegment
@@ -30,8 +31,8 @@ class HighwaySegment
 
 	// graph generation functions
 	std::string segment_name();
-	const char* clinchedby_code(char*, unsigned int);
-	void write_label(std::ofstream&, std::vector<HighwaySystem*> *);
+	const char* clinchedby_code(char*, const TMBitset<TravelerList*, uint32_t>*);
+	void write_label(std::string&, std::vector<HighwaySystem*> *);
 	HighwaySegment* canonical_edge_segment();
 	bool same_ap_routes(HighwaySegment*);
 	bool same_vis_routes(HighwaySegment*);
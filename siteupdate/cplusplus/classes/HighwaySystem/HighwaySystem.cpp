@@ -70,6 +70,7 @@ HighwaySystem::HighwaySystem(std::string &line, ErrorList &el)
 		case 'p': num_preview++;
 	}
 	is_subgraph_system = 0;
+	scope_neighbor = Args::scope.size() && scope.at(systemname);
 	std::cout /*<< systemname*/ << '.' << std::flush;
 
 	// read chopped routes CSV
@@ -135,6 +136,7 @@ void HighwaySystem::systems_csv(ErrorList& el)
 		while(getline(file, line)) if (line.size())
 		{	if (line.back() == 0x0D) line.pop_back();	// trim DOS newlines
 			if (line[0] == '#') continue;
+			if (Args::scope.size() && !scope.count(line.substr(0, line.find(';')))) continue;
 			if (strchr(line.data(), '"'))
 				el.add_error("Double quotes in systems.csv line: "+line);
 			lines.emplace_back(std::move(line));
@@ -151,7 +153,7 @@ void HighwaySystem::systems_csv(ErrorList& el)
 	file.close();
 }
 
-void HighwaySystem::ve_thread(std::mutex* mtx, std::vector<HGVertex>* vertices, TMArray<HGEdge>* edges)
+void HighwaySystem::ve_thread(std::mutex* mtx, std::vector<HGVertex>* vertices, TMArray<HGEdge>* edges, HGEdge** ve_edges, unsigned int* offsets)
 {	while (it != syslist.end())
 	{	for (mtx->lock(); it != syslist.end(); it++)
 		  if (it->is_subgraph_system) break;
@@ -159,25 +161,19 @@ void HighwaySystem::ve_thread(std::mutex* mtx, std::vector<HGVertex>* vertices,
 		HighwaySystem& h = *it++;
 		mtx->unlock();
 
-		h.vertices.alloc(vertices->data(), vertices->size());
-		h.edges.alloc(edges->data, edges->size);
+		TMBitset<HGVertex*, uint64_t> mv(vertices->data(), vertices->size());
+		TMBitset<HGEdge*,   uint64_t> me(edges->data, edges->size);
 		for (Route& r : h.routes)
 		  for (Waypoint& w : r.points)
-		  { HGVertex* v = w.hashpoint()->vertex;
-		    if (h.vertices.add_value(v))
-		      for (HGEdge* e : v->incident_edges)
-			if (e->segment->concurrent)
-			{ for (HighwaySegment* s : *e->segment->concurrent)
-			    if (s->route->system == &h)
-			    {	h.edges.add_value(e);
-				break;
-			    }
-			}
-			else if (e->segment->route->system == &h)
-				h.edges.add_value(e);
-		  }
-		h.vertices.shrink_to_fit();
-		h.edges.shrink_to_fit();
+		    mv.add_value(w.hashpoint()->vertex);
+		// of the edges HighwayGraph sorted into this system,
+		// keep those incident to its vertices
+		size_t const i = &h - syslist.data;
+		for (HGEdge **e = ve_edges+offsets[i], **end = ve_edges+offsets[i+1]; e < end; e++)
+		  if (mv.has_value((*e)->vertex1) || mv.has_value((*e)->vertex2))
+		    me.add_value(*e);
+		h.vertices.assign(mv, vertices->data());
+		h.edges.assign(me, edges->data);
 	}
 }
 
@@ -5,7 +5,7 @@ class HGVertex;
 class Region;
 class Route;
 #include "../../templates/TMArray.cpp"
-#include "../../templates/TMBitset.cpp"
+#include "../../templates/TMRoaring.cpp"
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -37,10 +37,11 @@ class HighwaySystem
 	char level; // 'a' for active, 'p' for preview, 'd' for devel
 
 	bool is_subgraph_system;
+	bool scope_neighbor;	// loaded only as context for a scoped errorcheck
 	TMArray<Route> routes;
 	TMArray<ConnectedRoute> con_routes;
-	TMBitset<HGVertex*, uint64_t> vertices;
-	TMBitset<HGEdge*,   uint64_t> edges;
+	TMRoaring<HGVertex*> vertices;
+	TMRoaring<HGEdge*>   edges;
 	std::unordered_map<Region*, double> mileage_by_region;
 	std::unordered_set<std::string>listnamesinuse, unusedaltroutenames;
 	std::mutex mtx;
@@ -50,6 +51,7 @@ class HighwaySystem
 	static std::unordered_map<std::string, HighwaySystem*> sysname_hash;
 	static unsigned int num_active;
 	static unsigned int num_preview;
+	static std::unordered_map<std::string, bool> scope; // systems to load in a scoped errorcheck; true for neighbors
 
 	HighwaySystem(std::string &, ErrorList &);
 
@@ -65,5 +67,8 @@ class HighwaySystem
 	void mark_routes_in_use(std::string&, std::string&);
 
 	static void systems_csv(ErrorList&);
-	static void ve_thread(std::mutex* mtx, std::vector<HGVertex>*, TMArray<HGEdge>*);
+	static bool find_scope();
+	static std::unordered_set<std::string> roots_in_scope();
+	static void route_index();
+	static void ve_thread(std::mutex* mtx, std::vector<HGVertex>*, TMArray<HGEdge>*, HGEdge**, unsigned int*);
 };
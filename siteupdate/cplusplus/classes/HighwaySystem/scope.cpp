@@ -0,0 +1,140 @@
+#define FMT_HEADER_ONLY
+#include "HighwaySystem.h"
+#include "../Args/Args.h"
+#include "../Route/Route.h"
+#include "../Waypoint/Waypoint.h"
+#include "../../functions/tmstring.h"
+#include <array>
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+
+std::unordered_map<std::string, bool> HighwaySystem::scope;
+
+void HighwaySystem::route_index()
+{	// bounding box of each route's waypoints, for later scoped errorchecks
+	std::ofstream index(Args::logfilepath+"/routebboxes.csv");
+	index << "System;Root;MinLat;MinLng;MaxLat;MaxLng\n";
+	for (HighwaySystem& h : syslist)
+	  for (Route& r : h.routes)
+	  {	if (!r.points.size) continue;
+		double min_lat = 90, min_lng = 180, max_lat = -90, max_lng = -180;
+		for (Waypoint& w : r.points)
+		{	if (w.lat < min_lat) min_lat = w.lat;
+			if (w.lng < min_lng) min_lng = w.lng;
+			if (w.lat > max_lat) max_lat = w.lat;
+			if (w.lng > max_lng) max_lng = w.lng;
+		}
+		index << fmt::format("{};{};{:.15};{:.15};{:.15};{:.15}\n", h.systemname, r.root, min_lat, min_lng, max_lat, max_lng);
+	  }
+	index.close();
+}
+
+bool HighwaySystem::find_scope()
+{	/* Populate the scope map for a scoped errorcheck: the systems
+	named in or containing the files in Args::scope, plus "neighbor"
+	systems with a route whose bounding box, per routebboxes.csv from
+	a previous full run, overlaps that of a .wpt file of a system in
+	scope. Routes colocated with or near-missing those can only be found
+	within that box, so neighbors provide everything the datachecks,
+	NMP & concurrency detection need for the systems in scope. */
+	std::vector<std::string> wpts;
+	for (std::string& item : Args::scope)
+	  if (item.size() > 4 && !strcmp(item.data()+item.size()-4, ".wpt"))
+	  {	// path/to/data/REGION/system/root.wpt
+		size_t end = item.rfind('/');
+		size_t begin = end == std::string::npos ? end : item.rfind('/', end-1);
+		if (begin == std::string::npos)
+		{	std::cout << "Fatal error: can't find system directory in " << item << std::endl;
+			return 1;
+		}
+		scope[item.substr(begin+1, end-begin-1)] = 0;
+		wpts.push_back(item);
+	  }
+	  else	scope[item] = 0;
+
+	// The whole system is in scope even if only one of its files is listed,
+	// its other routes checked & reported on too, so take every .wpt file
+	// listed in each system's .csv.
+	for (auto& s : scope)
+	{	std::ifstream file(Args::datapath+"/data/_systems/"+s.first+".csv");
+		if (!file)
+		{	std::cout << "Fatal error: could not open " << Args::datapath << "/data/_systems/" << s.first << ".csv" << std::endl;
+			return 1;
+		}
+		std::string line;
+		getline(file, line); // ignore header line
+		while (getline(file, line))
+		{	while ( line.size() && strchr("\r\t ", line.back()) ) line.pop_back();
+			// System;Region;Route;Banner;Abbrev;City;Root;AltRouteNames
+			std::string f[8];
+			std::string* fields[8] = {f, f+1, f+2, f+3, f+4, f+5, f+6, f+7};
+			size_t NumFields = 8;
+			split(line, fields, NumFields, ';');
+			if (NumFields == 8 && f[6].size())
+				wpts.push_back(Args::datapath+"/data/"+f[1]+"/"+s.first+"/"+lower(f[6].data())+".wpt");
+		}
+	}
+
+	// bounding boxes of the files in scope, padded by the NMP threshold
+	std::vector<std::array<double,4>> boxes;
+	for (std::string& filename : wpts)
+	{	std::ifstream file(filename);
+		std::string line;
+		std::array<double,4> box = {90, 180, -90, -180};
+		while (getline(file, line))
+		{	const char* lat = strstr(line.data(), "lat=");
+			const char* lng = strstr(line.data(), "lon=");
+			if (!lat || !lng) continue;
+			double y = strtod(lat+4, 0);
+			double x = strtod(lng+4, 0);
+			if (y < box[0]) box[0] = y;
+			if (x < box[1]) box[1] = x;
+			if (y > box[2]) box[2] = y;
+			if (x > box[3]) box[3] = x;
+		}
+		if (box[0] > box[2]) continue;	// no coordinates found
+		box[0] -= Args::nmpthreshold; box[1] -= Args::nmpthreshold;
+		box[2] += Args::nmpthreshold; box[3] += Args::nmpthreshold;
+		boxes.push_back(box);
+	}
+
+	// neighbor systems from the cached index
+	std::ifstream index(Args::logfilepath+"/routebboxes.csv");
+	if (!index)
+	{	std::cout << "Fatal error: scoped errorcheck needs " << Args::logfilepath
+			  << "/routebboxes.csv from a previous full site update." << std::endl;
+		return 1;
+	}
+	std::string line;
+	getline(index, line); // ignore header line
+	while (getline(index, line))
+	{	size_t semicolon = line.find(';');
+		if (semicolon == std::string::npos) continue;
+		std::string system(line, 0, semicolon);
+		if (scope.count(system)) continue;
+		const char* c = strchr(line.data()+semicolon+1, ';');
+		if (!c) continue;
+		double min_lat = strtod(c+1, (char**)&c);
+		double min_lng = strtod(c+1, (char**)&c);
+		double max_lat = strtod(c+1, (char**)&c);
+		double max_lng = strtod(c+1, 0);
+		for (std::array<double,4>& box : boxes)
+		  if (min_lat <= box[2] && max_lat >= box[0] && min_lng <= box[3] && max_lng >= box[1])
+		  {	scope[system] = 1;
+			break;
+		  }
+	}
+	index.close();
+	return 0;
+}
+
+// roots of the routes checked & reported on in a scoped errorcheck,
+// for leaving other routes' FP entries out of the unmatched FP logs
+std::unordered_set<std::string> HighwaySystem::roots_in_scope()
+{	std::unordered_set<std::string> roots;
+	for (HighwaySystem& h : syslist)
+	  if (!h.scope_neighbor)
+	    for (Route& r : h.routes) roots.insert(r.root);
+	return roots;
+}
@@ -70,7 +70,7 @@ std::string& Region::continent_code()
 {	return continent->first;
 }
 
-void Region::ve_thread(std::mutex* mtx, std::vector<HGVertex>* vertices, TMArray<HGEdge>* edges)
+void Region::ve_thread(std::mutex* mtx, std::vector<HGVertex>* vertices, TMArray<HGEdge>* edges, HGEdge** ve_edges, unsigned int* offsets)
 {	while (it != allregions.end())
 	{	for (mtx->lock(); it != allregions.end(); it++)
 		  if (it->active_preview_mileage) break;
@@ -78,18 +78,19 @@ void Region::ve_thread(std::mutex* mtx, std::vector<HGVertex>* vertices, TMArray
 		Region& rg = *it++;
 		mtx->unlock();
 
-		rg.vertices.alloc(vertices->data(), vertices->size());
-		rg.edges.alloc(edges->data, edges->size);
+		TMBitset<HGVertex*, uint64_t> mv(vertices->data(), vertices->size());
+		TMBitset<HGEdge*,   uint64_t> me(edges->data, edges->size);
 		for (Route* r : rg.routes)
 		  if (r->system->active_or_preview())
 		    for (Waypoint& w : r->points)
-		    { HGVertex* v = w.hashpoint()->vertex;
-		      if (rg.vertices.add_value(v))
-			for (HGEdge* e : v->incident_edges)
-			  if (e->segment->route->region == &rg)
-			    rg.edges.add_value(e);
-		    }
-		rg.vertices.shrink_to_fit();
-		rg.edges.shrink_to_fit();
+		      mv.add_value(w.hashpoint()->vertex);
+		// of the edges HighwayGraph sorted into this region,
+		// keep those incident to its vertices
+		size_t const i = &rg - allregions.data;
+		for (HGEdge **e = ve_edges+offsets[i], **end = ve_edges+offsets[i+1]; e < end; e++)
+		  if (mv.has_value((*e)->vertex1) || mv.has_value((*e)->vertex2))
+		    me.add_value(*e);
+		rg.vertices.assign(mv, vertices->data());
+		rg.edges.assign(me, edges->data);
 	}
 }
@@ -4,7 +4,7 @@ class HGVertex;
 class Route;
 class Waypoint;
 #include "../../templates/TMArray.cpp"
-#include "../../templates/TMBitset.cpp"
+#include "../../templates/TMRoaring.cpp"
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -48,8 +48,8 @@ class Region
 	double active_preview_mileage;
 	double overall_mileage;
 	std::vector<Route*> routes;
-	TMBitset<HGVertex*, uint64_t> vertices;
-	TMBitset<HGEdge*,   uint64_t> edges;
+	TMRoaring<HGVertex*> vertices;
+	TMRoaring<HGEdge*>   edges;
 
 	static TMArray<Region> allregions;
 	static Region* it;
@@ -64,5 +64,5 @@ class Region
 	std::string &continent_code();
 	static void read_csvs(ErrorList&);
 	static void cccsv(ErrorList&, std::string, std::string, size_t, size_t, std::vector<std::pair<std::string, std::string>>&);
-	static void ve_thread(std::mutex* mtx, std::vector<HGVertex>*, TMArray<HGEdge>*);
+	static void ve_thread(std::mutex* mtx, std::vector<HGVertex>*, TMArray<HGEdge>*, HGEdge**, unsigned int*);
 };
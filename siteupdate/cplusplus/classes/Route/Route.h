@@ -83,7 +83,7 @@ class Route
 	Route(std::string &, HighwaySystem *, ErrorList &);
 
 	std::string str();
-	void read_wpt(WaypointQuadtree *, ErrorList *, bool);
+	void read_wpt(WaypointQuadtree *, ErrorList *);
 	void print_route();
 	std::string chopped_rtes_line();
 	std::string readable_name();
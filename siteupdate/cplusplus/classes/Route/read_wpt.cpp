@@ -1,19 +1,16 @@
-#define FMT_HEADER_ONLY
 #include "Route.h"
 #include "../Args/Args.h"
 #include "../Datacheck/Datacheck.h"
+#include "../DatacheckRule/DatacheckRule.h"
 #include "../ErrorList/ErrorList.h"
 #include "../HighwaySegment/HighwaySegment.h"
 #include "../HighwaySystem/HighwaySystem.h"
 #include "../Waypoint/Waypoint.h"
 #include "../WaypointQuadtree/WaypointQuadtree.h"
-#include <fmt/format.h>
 
-void Route::read_wpt(WaypointQuadtree *all_waypoints, ErrorList *el, bool usa_flag)
+void Route::read_wpt(WaypointQuadtree *all_waypoints, ErrorList *el)
 {	/* read data into the Route's waypoint list from a .wpt file */
 	std::string filename = Args::datapath + "/data/" + rg_str + "/" + system->systemname + "/" + root + ".wpt";
-	Waypoint *last_visible;
-	double vis_dist = 0;
 
 	// remove full path from all_wpt_files list
 	awf_mtx.lock();
@@ -72,64 +69,16 @@ void Route::read_wpt(WaypointQuadtree *all_waypoints, ErrorList *el, bool usa_fl
 
 		all_waypoints->insert(w, 1);
 
-		// single-point Datachecks, and HighwaySegment
-		w->out_of_bounds();
-		if (w > points.data)
-		{	// add HighwaySegment, if not first point
-			new(s) HighwaySegment(w, this);
-			// placement new
-			// visible distance update, and last segment length check
-			double last_distance = s->length;
-			vis_dist += last_distance;
-			if (last_distance > 20)
-			  Datacheck::add(this, w[-1].label, w->label, "", "LONG_SEGMENT", fmt::format("{:.2f}", last_distance));
-			s++;
-		}
-		else if (w->is_hidden) // look for hidden beginning
-		     {	Datacheck::add(this, w->label, "", "", "HIDDEN_TERMINUS", "");
-			last_visible = w;
-		     }
-		// checks for visible points
-		if (!w->is_hidden)
-		{	const char *slash = strchr(w->label.data(), '/');
-			if (usa_flag && w->label.size() >= 2)
-			{	w->bus_with_i();
-				w->interstate_no_hyphen();
-				w->us_letter();
-			}
-			w->label_invalid_ends();
-			w->label_looks_hidden();
-			w->label_lowercase();
-			w->label_parens();
-			w->label_slashes(slash);
-			w->lacks_generic();
-			w->underscore_datachecks(slash);
-			w->visible_distance(vis_dist, last_visible);
-		}
+		// add HighwaySegment, if not first point
+		if (w > points.data) new(s++) HighwaySegment(w, this);
+				     // placement new
 		++w;
 	}
 	delete[] wptdata;
 
-	// per-route datachecks
+	// waypoint datachecks
+	DatacheckRule::run(*this, DatacheckRule::wpt);
 	if (points.size < 2) el->add_error("Route contains fewer than 2 points: " + str());
-	else {	// look for hidden endpoint
-		if (points.back().is_hidden)
-		{	Datacheck::add(this, points.back().label, "", "", "HIDDEN_TERMINUS", "");
-			// do one last check in case a VISIBLE_DISTANCE error coexists
-			// here, as this was only checked earlier for visible points
-			points.back().visible_distance(vis_dist, last_visible);
-		}
-		// angle check is easier with a traditional for loop and array indices
-		for (Waypoint* p = points.data+1; p < points.end()-1; p++)
-		{	//cout << "computing angle for " << p[-1].str() << ' ' << p->str() << ' ' << p[1].str() << endl;
-			if (p[-1].same_coords(p) || p[1].same_coords(p))
-				Datacheck::add(this, p[-1].label, p->label, p[1].label, "BAD_ANGLE", "");
-			else {	double angle = p->angle();
-				if (angle > 135)
-				  Datacheck::add(this, p[-1].label, p->label, p[1].label, "SHARP_ANGLE", fmt::format("{:.2f}", angle));
-			     }
-		}
-	     }
 	//std::cout << '.' << std::flush;
 	//std::cout << str() << std::flush;
 	//print_route();
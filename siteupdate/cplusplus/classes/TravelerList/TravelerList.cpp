@@ -14,9 +14,6 @@
 
 TravelerList::TravelerList(std::string& travname, ErrorList* el)
 {	// initialize object variables
-	traveler_num = new unsigned int[Args::numthreads];
-		       // deleted by ~TravelerList
-	traveler_num[0] = this - allusers.data; // init for master traveled graph
 	traveler_name.assign(travname, 0, travname.size()-Args::userlistext.size()); // strip extension from end of travname
 	if (traveler_name.size() > DBFieldLength::traveler)
 	  el->add_error("Traveler name " + traveler_name + " > " + std::to_string(DBFieldLength::traveler) + "bytes");
@@ -162,11 +159,9 @@ TravelerList::TravelerList(std::string& travname, ErrorList* el)
 	splist.close();
 }
 
-TravelerList::~TravelerList() {delete[] traveler_num;}
-
 void TravelerList::get_ids(ErrorList& el)
 {	ids = std::move(Args::userlist);
-	if (ids.empty())
+	if (ids.empty() && Args::scope.empty())
 	{	DIR *dir;
 		dirent *ent;
 		if ((dir = opendir (Args::userlistfilepath.data())) != NULL)
@@ -185,6 +180,10 @@ void TravelerList::get_ids(ErrorList& el)
 	tl_it = allusers.alloc(ids.size());
 }
 
+TravelerList::TravelerList(std::string& name): traveler_name(name)
+{	// restore from a checkpoint; other data are added by Checkpoint::read
+}
+
 /* Return active mileage across all regions */
 double TravelerList::active_only_miles()
 {	double mi = 0;
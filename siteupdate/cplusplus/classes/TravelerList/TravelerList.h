@@ -39,7 +39,6 @@ class TravelerList
 	std::unordered_set<Route*> updated_routes;
 	std::vector<std::pair<Route*,double>> cr_values;		// for the clinchedRoutes DB table
 	std::vector<std::pair<ConnectedRoute*,double>> ccr_values;	// for the clinchedConnectedRoutes DB table
-	unsigned int *traveler_num;
 	static std::mutex mtx;	// for avoiding data races when creating userlog timestamps
 	static std::list<std::string> ids;
 	static std::list<std::string>::iterator id_it;
@@ -52,7 +51,7 @@ class TravelerList
 	static std::unordered_map<std::string, std::vector<std::string>> listinfo;
 
 	TravelerList(std::string&, ErrorList*);
-	~TravelerList();
+	TravelerList(std::string&);
 
 	double active_only_miles();
 	double active_preview_miles();
@@ -1,6 +1,7 @@
 #define FMT_HEADER_ONLY
 #include "Waypoint.h"
 #include "../Datacheck/Datacheck.h"
+#include "../DatacheckSnapshot/DatacheckSnapshot.h"
 #include "../ErrorList/ErrorList.h"
 #include "../DBFieldLength/DBFieldLength.h"
 #include "../HighwaySegment/HighwaySegment.h"
@@ -88,6 +89,10 @@ Waypoint::Waypoint(char *line, Route *rte, ErrorList& el, char*const wptdata)
 	colocated = 0;
 }
 
+// restore from a checkpoint; alt_labels are added by Checkpoint::read
+Waypoint::Waypoint(Route *rte, double Lat, double Lng, std::string& Label):
+	route(rte), colocated(0), lat(Lat), lng(Lng), label(Label), is_hidden(Label[0] == '+') {}
+
 std::string Waypoint::str()
 {	return fmt::format("{} {} ({:.15},{:.15})", route->root, label, lat, lng);
 }
@@ -192,13 +197,19 @@ std::string Waypoint::root_at_label()
 {	return route->root + "@" + label;
 }
 
+// sort the near miss points for consistent ordering to facilitate NMP FP marking,
+// & construct string for nearmisspoints.log & FP matching
+std::string Waypoint::nmp_line()
+{	near_miss_points.sort(sort_root_at_label);
+	std::string line = str() + " NMP";
+	for (Waypoint *other_w : near_miss_points) line += " " + other_w->str();
+	return line;
+}
+
 void Waypoint::nmplogs(std::unordered_set<std::string> &nmpfps, std::ofstream &nmpnmp, std::list<std::string> &nmploglines)
-{	if (!near_miss_points.empty())
-	{	// sort the near miss points for consistent ordering to facilitate NMP FP marking
-		near_miss_points.sort(sort_root_at_label);
-		// construct string for nearmisspoints.log & FP matching
-		std::string nmpline = str() + " NMP";
-		for (Waypoint *other_w : near_miss_points) nmpline += " " + other_w->str();
+{	// in a scoped errorcheck, log only points in scope
+	if (!near_miss_points.empty() && !route->system->scope_neighbor)
+	{	std::string nmpline = nmp_line();
 		// check for string in fp list
 		std::unordered_set<std::string>::iterator fpit = nmpfps.find(nmpline);
 		bool fp = fpit != nmpfps.end();
@@ -209,28 +220,31 @@ void Waypoint::nmplogs(std::unordered_set<std::string> &nmpfps, std::ofstream &n
 			if (li) li_count++;
 			// make sure we only plot once, since the NMP should be listed
 			// both ways (other_w in w's list, w in other_w's list)
-			if (sort_root_at_label(this, other_w))
-			{	char s[51];
-				nmpnmp << root_at_label();
-				*fmt::format_to(s, " {:.15}", lat)=0; nmpnmp<<s;
-				*fmt::format_to(s, " {:.15}", lng)=0; nmpnmp<<s;
-				if (fp || li)
-				{	nmpnmp << ' ';
-					if (fp) nmpnmp << "FP";
-					if (li) nmpnmp << "LI";
-				}
-				nmpnmp << '\n';
-
-				nmpnmp << other_w->root_at_label();
-				*fmt::format_to(s, " {:.15}", other_w->lat)=0; nmpnmp<<s;
-				*fmt::format_to(s, " {:.15}", other_w->lng)=0; nmpnmp<<s;
-				if (fp || li)
+			// Neighbors outside a scoped errorcheck's scope don't list their own NMPs,
+			// so plot those here, as a full run would from the neighbor: first point
+			// in sort_root_at_label order, FP per the neighbor's own NMP line.
+			// That line's FP entry is left in nmpfps, & out of the unmatched log.
+			Waypoint *w1 = this, *w2 = other_w;
+			bool pair_fp = fp;
+			if (!sort_root_at_label(w1, w2))
+			{	if (!other_w->route->system->scope_neighbor) continue;
+				std::swap(w1, w2);
+				pair_fp = nmpfps.count(w1->nmp_line());
+			}
+			char s[51];
+			for (Waypoint* w : {w1, w2})
+			{	nmpnmp << w->root_at_label();
+				*fmt::format_to(s, " {:.15}", w->lat)=0; nmpnmp<<s;
+				*fmt::format_to(s, " {:.15}", w->lng)=0; nmpnmp<<s;
+				if (pair_fp || li)
 				{	nmpnmp << ' ';
-					if (fp) nmpnmp << "FP";
+					if (pair_fp) nmpnmp << "FP";
 					if (li) nmpnmp << "LI";
 				}
 				nmpnmp << '\n';
 			}
+			DatacheckSnapshot::nmp_pairs.emplace_back(w1->root_at_label() + ' ' + w2->root_at_label(),
+				fmt::format("({:.15},{:.15}) ({:.15},{:.15})", w1->lat, w1->lng, w2->lat, w2->lng), pair_fp | li << 1);
 		}
 		// indicate if this was in the FP list or if it's off by exact amt
 		// so looks like it's intentional, and detach near_miss_points list
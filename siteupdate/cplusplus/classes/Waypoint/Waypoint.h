@@ -32,6 +32,7 @@ class Waypoint
 	bool is_hidden;
 
 	Waypoint(char *, Route *, ErrorList&, char* const);
+	Waypoint(Route *, double, double, std::string&);
 
 	std::string str();
 	bool same_coords(Waypoint *);
@@ -42,6 +43,7 @@ class Waypoint
 	std::string simple_waypoint_name();
 	bool is_or_colocated_with_active_or_preview();
 	std::string root_at_label();
+	std::string nmp_line();
 	void nmplogs(std::unordered_set<std::string> &, std::ofstream &, std::list<std::string> &);
 	Waypoint* hashpoint();
 	bool label_references_route(Route *);
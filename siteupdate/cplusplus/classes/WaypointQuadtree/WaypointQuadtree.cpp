@@ -28,6 +28,7 @@ WaypointQuadtree::WaypointQuadtree(double MinLat, double MinLng, double MaxLat,
 	sw_child = 0;
 	se_child = 0;
 	unique_locations = 0;
+	v_begin = v_end = 0;
 }
 
 void WaypointQuadtree::refine()
@@ -160,7 +161,11 @@ void WaypointQuadtree::nmplogs()
 	ofstream nmpfpsunmatchedfile(Args::logfilepath+"/nmpfpsunmatched.log");
 	list<string> nmpfplist(nmpfps.begin(), nmpfps.end());
 	nmpfplist.sort();
+	// in a scoped errorcheck, only entries whose first point is in scope could have been matched
+	unordered_set<string> in_scope;
+	if (Args::scope.size()) in_scope = HighwaySystem::roots_in_scope();
 	for (string &line : nmpfplist)
+	  if (Args::scope.empty() || in_scope.count(line.substr(0, line.find(' '))))
 		nmpfpsunmatchedfile << line << '\n';
 	nmpfpsunmatchedfile.close();
 	nmpfplist.clear();
@@ -17,6 +17,9 @@ class WaypointQuadtree
 	std::list<Waypoint*> points;
 	unsigned int unique_locations;
 	std::recursive_mutex mtx;
+	// terminal nodes' graph vertices, for PlaceRadius searches:
+	unsigned int v_begin, v_end;				// range in PlaceRadius::leaf_v
+	double v_min_lat, v_max_lat;				// latitude range
 
 	bool refined();
 	WaypointQuadtree(double, double, double, double);
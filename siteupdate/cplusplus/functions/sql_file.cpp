@@ -14,8 +14,20 @@
 #include "../classes/TravelerList/TravelerList.h"
 #include "../classes/Waypoint/Waypoint.h"
 #include <fmt/format.h>
+#include <algorithm>
 #include <fstream>
 
+// Mileage maps are unordered, & their iteration order depends on how they
+// were built, e.g. from scratch or resumed from a checkpoint. Write their rows
+// in a fixed order: by pointer, which is Region::allregions or syslist order.
+template <class M> static std::vector<typename M::value_type*> sorted(M& m)
+{	std::vector<typename M::value_type*> v;
+	v.reserve(m.size());
+	for (auto& kv : m) v.push_back(&kv);
+	std::sort(v.begin(), v.end(), [](typename M::value_type* a, typename M::value_type* b) {return a->first < b->first;});
+	return v;
+}
+
 void sqlfile1
     (	ElapsedTime *et,
 	std::list<std::string*> *updates,
@@ -295,11 +307,11 @@ void sqlfile1
 	first = 1;
 	for (HighwaySystem& h : HighwaySystem::syslist)
 	  if (h.active_or_preview())
-	    for (std::pair<Region* const,double>& rm : h.mileage_by_region)
+	    for (std::pair<Region* const,double>* rm : sorted(h.mileage_by_region))
 	    {	if (!first) sqlfile << ',';
 		first = 0;
-		*fmt::format_to(fstr, "','{}')\n", rm.second) = 0;
-		sqlfile << "('" << h.systemname << "','" << rm.first->code << fstr;
+		*fmt::format_to(fstr, "','{}')\n", rm->second) = 0;
+		sqlfile << "('" << h.systemname << "','" << rm->first->code << fstr;
 	    }
 	sqlfile << ";\n";
 
@@ -314,13 +326,13 @@ void sqlfile1
 	sqlfile << "INSERT INTO clinchedOverallMileageByRegion VALUES\n";
 	first = 1;
 	for (TravelerList& t : TravelerList::allusers)
-	  for (std::pair<Region* const,double>& rm : t.active_preview_mileage_by_region)
+	  for (std::pair<Region* const,double>* rm : sorted(t.active_preview_mileage_by_region))
 	  {	if (!first) sqlfile << ',';
 		first = 0;
-		auto it = t.active_only_mileage_by_region.find(rm.first);
+		auto it = t.active_only_mileage_by_region.find(rm->first);
 		double active_miles = (it != t.active_only_mileage_by_region.end()) ? it->second : 0;
-		*fmt::format_to(fstr, "','{}','{}')\n", active_miles, rm.second) = 0;
-		sqlfile << "('" << rm.first->code << "','" << t.traveler_name << fstr;
+		*fmt::format_to(fstr, "','{}','{}')\n", active_miles, rm->second) = 0;
+		sqlfile << "('" << rm->first->code << "','" << t.traveler_name << fstr;
 	  }
 	sqlfile << ";\n";
 
@@ -336,13 +348,13 @@ void sqlfile1
 	sqlfile << "INSERT INTO clinchedSystemMileageByRegion VALUES\n";
 	first = 1;
 	for (TravelerList& t : TravelerList::allusers)
-	  for (auto& csmbr : t.system_region_mileages)
-	  {	auto& systemname = csmbr.first->systemname;
-		for (auto& rm : csmbr.second)
+	  for (auto csmbr : sorted(t.system_region_mileages))
+	  {	auto& systemname = csmbr->first->systemname;
+		for (auto rm : sorted(csmbr->second))
 		{	if (!first) sqlfile << ',';
 			first = 0;
-			*fmt::format_to(fstr, "{}", rm.second) = 0;
-			sqlfile << "('" << systemname << "','" << rm.first->code << "','" << t.traveler_name << "','" << fstr << "')\n";
+			*fmt::format_to(fstr, "{}", rm->second) = 0;
+			sqlfile << "('" << systemname << "','" << rm->first->code << "','" << t.traveler_name << "','" << fstr << "')\n";
 		}
 	  }
 	sqlfile << ";\n";
@@ -531,7 +543,8 @@ void sqlfile2(ElapsedTime *et, std::list<std::array<std::string,3>> *graph_types
 			}
 			sqlfile << ";\n";
 		}
-		sqlfile << "CREATE TABLE graphs (filename VARCHAR(" << DBFieldLength::graphFilename
+		// room for a .gz extension if compressed
+		sqlfile << "CREATE TABLE graphs (filename VARCHAR(" << DBFieldLength::graphFilename + (Args::gzipgraphs ? 3 : 0)
 			<< "), descr VARCHAR(" << DBFieldLength::graphDescr
 			<< "), vertices INTEGER, edges INTEGER, travelers INTEGER, "
 			<< "format VARCHAR(" << DBFieldLength::graphFormat
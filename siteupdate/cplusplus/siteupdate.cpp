@@ -14,8 +14,11 @@ This module defines classes to represent the contents of a
 */
 
 #include "classes/Args/Args.h"
+#include "classes/Checkpoint/Checkpoint.h"
 #include "classes/DBFieldLength/DBFieldLength.h"
 #include "classes/Datacheck/Datacheck.h"
+#include "classes/DatacheckRule/DatacheckRule.h"
+#include "classes/DatacheckSnapshot/DatacheckSnapshot.h"
 #include "classes/ElapsedTime/ElapsedTime.h"
 #include "classes/ErrorList/ErrorList.h"
 #include "classes/GraphGeneration/GraphListEntry.h"
@@ -23,6 +26,7 @@ This module defines classes to represent the contents of a
 #include "classes/GraphGeneration/HGVertex.h"
 #include "classes/GraphGeneration/HighwayGraph.h"
 #include "classes/GraphGeneration/PlaceRadius.h"
+#include "classes/GraphGeneration/TMGWriter.h"
 #include "classes/HighwaySegment/HighwaySegment.h"
 #include "classes/HighwaySystem/HighwaySystem.h"
 #include "classes/Region/Region.h"
@@ -55,6 +59,7 @@ int main(int argc, char *argv[])
 
 	// argument parsing
 	if (Args::init(argc, argv)) return 1;
+	if (DatacheckRule::select()) return 1;
       #ifndef threading_enabled
 	Args::numthreads = 1;
       #else
@@ -78,88 +83,120 @@ int main(int argc, char *argv[])
 	cout << et.et() << "Reading region, country, and continent descriptions." << endl;
 	Region::read_csvs(el);
 
+	if (Args::scope.size())
+	{	cout << et.et() << "Finding systems in scope for errorcheck." << endl;
+		if (HighwaySystem::find_scope()) return 1;
+	}
+
 	// Create an array of HighwaySystem objects, one per system in systems.csv file
 	cout << et.et() << "Reading systems list in " << Args::datapath << "/" << Args::systemsfile << "." /*<< endl*/;
 	HighwaySystem::systems_csv(el);
 
-	// For tracking whether any .wpt files are in the directory tree
-	// that do not have a .csv file entry that causes them to be
-	// read into the data
-	cout << et.et() << "Finding all .wpt files. " << flush;
-	unordered_set<string> splitsystems;
-	crawl_rte_data(Args::datapath+"/data", splitsystems, 0);
-	cout << Route::all_wpt_files.size() << " files found." << endl;
+	#include "tasks/read_updates.cpp"
 
 	// For finding colocated Waypoints and concurrent segments, we have
 	// quadtree of all Waypoints in existence to find them efficiently
 	WaypointQuadtree all_waypoints(-90,-180,90,180);
 
-	cout << et.et() << "Reading waypoints for all routes." << endl;
-	#include "tasks/threaded/ReadWpt.cpp"
-
-	//cout << et.et() << "Writing WaypointQuadtree.tmg." << endl;
-	//all_waypoints.write_qt_tmg(Args::logfilepath+"/WaypointQuadtree.tmg");
-	cout << et.et() << "Sorting waypoints in Quadtree." << endl;
-	all_waypoints.sort();
-
-	cout << et.et() << "Finding unprocessed wpt files." << endl;
-	ofstream unprocessedfile(Args::logfilepath+"/unprocessedwpts.log");
-	if (Route::all_wpt_files.size())
-	     {	cout << Route::all_wpt_files.size() << " .wpt files in " << Args::datapath << "/data not processed, see unprocessedwpts.log." << endl;
-		list<string> all_wpts_list(Route::all_wpt_files.begin(), Route::all_wpt_files.end());
-		all_wpts_list.sort();
-		for (const string &f : all_wpts_list) unprocessedfile << strstr(f.data(), "data") << '\n';
-		Route::all_wpt_files.clear();
-	     }
-	else {	cout << "All .wpt files in " << Args::datapath << "/data processed." << endl;
-		unprocessedfile << "No unprocessed .wpt files.\n";
-	     }
-	unprocessedfile.close();
+	if (Args::resumefrom.empty())
+	{	// For tracking whether any .wpt files are in the directory tree
+		// that do not have a .csv file entry that causes them to be
+		// read into the data
+		cout << et.et() << "Finding all .wpt files. " << flush;
+		unordered_set<string> splitsystems;
+		if (Args::scope.empty())
+		{	crawl_rte_data(Args::datapath+"/data", splitsystems, 0);
+			cout << Route::all_wpt_files.size() << " files found." << endl;
+		} else	cout << "Skipped for scoped errorcheck." << endl;
+
+		cout << et.et() << "Reading waypoints for all routes." << endl;
+		#include "tasks/threaded/ReadWpt.cpp"
+
+		//cout << et.et() << "Writing WaypointQuadtree.tmg." << endl;
+		//all_waypoints.write_qt_tmg(Args::logfilepath+"/WaypointQuadtree.tmg");
+		cout << et.et() << "Sorting waypoints in Quadtree." << endl;
+		all_waypoints.sort();
+
+		if (Args::scope.empty())
+		{	cout << et.et() << "Writing routebboxes.csv." << endl;
+			HighwaySystem::route_index();
+		}
+
+		cout << et.et() << "Finding unprocessed wpt files." << endl;
+		ofstream unprocessedfile(Args::logfilepath+"/unprocessedwpts.log");
+		if (Route::all_wpt_files.size())
+		     {	cout << Route::all_wpt_files.size() << " .wpt files in " << Args::datapath << "/data not processed, see unprocessedwpts.log." << endl;
+			list<string> all_wpts_list(Route::all_wpt_files.begin(), Route::all_wpt_files.end());
+			all_wpts_list.sort();
+			for (const string &f : all_wpts_list) unprocessedfile << strstr(f.data(), "data") << '\n';
+			Route::all_wpt_files.clear();
+		     }
+		else if (Args::scope.size())
+			unprocessedfile << "Unprocessed .wpt files not checked in scoped errorcheck.\n";
+		else {	cout << "All .wpt files in " << Args::datapath << "/data processed." << endl;
+			unprocessedfile << "No unprocessed .wpt files.\n";
+		     }
+		unprocessedfile.close();
 
       #ifdef threading_enabled
-	cout << et.et() << "Searching for near-miss points." << endl;
-	HighwaySystem::it = HighwaySystem::syslist.begin();
-	THREADLOOP thr[t] = thread(NmpSearchThread, t, &list_mtx, &all_waypoints);
-	THREADLOOP thr[t].join();
+		cout << et.et() << "Searching for near-miss points." << endl;
+		HighwaySystem::it = HighwaySystem::syslist.begin();
+		THREADLOOP thr[t] = thread(NmpSearchThread, t, &list_mtx, &all_waypoints);
+		THREADLOOP thr[t].join();
       #endif
 
-	cout << et.et() << "Near-miss point log and tm-master.nmp file." << endl;
-	all_waypoints.nmplogs();
-
-	// if requested, rewrite data with near-miss points merged in
-	if (Args::nmpmergepath != "" && !Args::errorcheck)
-	{	cout << et.et() << "Writing near-miss point merged wpt files." << endl;
-		#include "tasks/threaded/NmpMerged.cpp"
+		cout << et.et() << "Near-miss point log and tm-master.nmp file." << endl;
+		all_waypoints.nmplogs();
+
+		// if requested, rewrite data with near-miss points merged in
+		if (Args::nmpmergepath != "" && !Args::errorcheck)
+		{	cout << et.et() << "Writing near-miss point merged wpt files." << endl;
+			#include "tasks/threaded/NmpMerged.cpp"
+		}
+
+		cout << et.et() << "Concurrent segment detection." << flush;
+		#include "tasks/concurrency_detection.cpp"
+
+		cout << et.et() << "Creating label hashes and checking route integrity." << endl;
+		#include "tasks/threaded/RteInt.cpp"
+
+		cout << et.et() << "Processing traveler list files:" << endl;
+		#include "tasks/threaded/ReadList.cpp"
+		cout << endl << et.et() << "Processed " << TravelerList::allusers.size << " traveler list files." << endl;
+
+		cout << et.et() << "Clearing route & label hash tables." << endl;
+		Route::root_hash.clear();
+		Route::pri_list_hash.clear();
+		Route::alt_list_hash.clear();
+		for (HighwaySystem& h : HighwaySystem::syslist)
+		  for (Route& r : h.routes)
+		  {	r.pri_label_hash.clear();
+			r.alt_label_hash.clear();
+			r.duplicate_labels.clear();
+		  }
+
+		cout << et.et() << "Writing route and label logs." << endl;
+		route_and_label_logs(&timestamp);
+
+		cout << et.et() << "Augmenting travelers for detected concurrent segments." << flush;
+		#include "tasks/threaded/ConcAug.cpp"
+
+		if (Args::checkpoint.size())
+		  if (el.error_list.size())
+			cout << et.et() << "SKIPPING checkpoint due to errors." << endl;
+		  else {cout << et.et() << "Writing checkpoint " << Args::checkpoint << '.' << endl;
+			Checkpoint::write(Args::checkpoint);
+		       }
 	}
-
-	cout << et.et() << "Concurrent segment detection." << flush;
-	#include "tasks/concurrency_detection.cpp"
-
-	cout << et.et() << "Creating label hashes and checking route integrity." << endl;
-	#include "tasks/threaded/RteInt.cpp"
-
-	#include "tasks/read_updates.cpp"
-
-	cout << et.et() << "Processing traveler list files:" << endl;
-	#include "tasks/threaded/ReadList.cpp"
-	cout << endl << et.et() << "Processed " << TravelerList::allusers.size << " traveler list files." << endl;
-
-	cout << et.et() << "Clearing route & label hash tables." << endl;
-	Route::root_hash.clear();
-	Route::pri_list_hash.clear();
-	Route::alt_list_hash.clear();
-	for (HighwaySystem& h : HighwaySystem::syslist)
-	  for (Route& r : h.routes)
-	  {	r.pri_label_hash.clear();
-		r.alt_label_hash.clear();
-		r.duplicate_labels.clear();
-	  }
-
-	cout << et.et() << "Writing route and label logs." << endl;
-	route_and_label_logs(&timestamp);
-
-	cout << et.et() << "Augmenting travelers for detected concurrent segments." << flush;
-	#include "tasks/threaded/ConcAug.cpp"
+	else {	cout << et.et() << "Resuming from checkpoint " << Args::resumefrom << '.' << endl;
+		if (!Checkpoint::read(Args::resumefrom, all_waypoints))
+		{	failure_cleanup(all_waypoints, colocate_counts, updates, systemupdates);
+			return 1;
+		}
+		cout << et.et() << "Restored " << TravelerList::allusers.size << " travelers." << endl;
+		cout << et.et() << "Sorting waypoints in Quadtree." << endl;
+		all_waypoints.sort();
+	     }
 
 	/*ofstream sanetravfile(Args::logfilepath+"/concurrent_travelers_sanity_check.log");
 	for (HighwaySystem& h : HighwaySystem::syslist)
@@ -183,6 +220,10 @@ int main(int argc, char *argv[])
 	cout << et.et() << "Writing stats csv files." << endl;
 	#include "tasks/threaded/StatsCsv.cpp"
 
+	if (Args::scope.size())
+	{	cout << et.et() << "Discarding datacheck errors for neighbor systems outside scope." << endl;
+		Datacheck::errors.remove_if([](Datacheck& d) {return d.route->system->scope_neighbor;});
+	}
 	cout << et.et() << "Reading datacheckfps.csv." << endl;
 	Datacheck::read_fps(el);
 	cout << et.et() << "Marking datacheck false positives." << flush;
@@ -191,6 +232,17 @@ int main(int argc, char *argv[])
 	Datacheck::unmatchedfps_log();
 	cout << et.et() << "Writing datacheck.log" << endl;
 	Datacheck::datacheck_log();
+	if (Args::resumefrom.empty())
+	{	cout << et.et() << "Writing datacheckrules.log" << endl;
+		DatacheckRule::log();
+	}
+	DatacheckSnapshot::build();
+	if (Args::dcsnapshot != "")
+	{	cout << et.et() << "Writing datacheckdiff.log" << endl;
+		DatacheckSnapshot::diff(Args::dcsnapshot);
+	}
+	cout << et.et() << "Writing datacheck.snp" << endl;
+	DatacheckSnapshot::write();
 
 	cout << et.et() << "Reading subgraph descriptions and checking for errors." << endl;
 	#include "tasks/graph_setup.cpp"
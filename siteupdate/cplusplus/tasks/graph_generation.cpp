@@ -14,12 +14,40 @@ graph_data.waypoint_naming_log.clear();
 
 	cout << et.et() << "Formatting vertex coordinate strings." << endl;
       #ifdef threading_enabled
-	THREADLOOP thr[t] = thread(VtxFmtThread, t, &graph_data.vertices);
-	THREADLOOP thr[t].join();
+	{	vector<string> coordbufs(Args::numthreads);
+		THREADLOOP thr[t] = thread(VtxFmtThread, t, &graph_data.vertices, &coordbufs[t]);
+		THREADLOOP thr[t].join();
+		HGVertex::pool_coordstrs(graph_data.vertices, coordbufs.data(), Args::numthreads);
+	}
       #else
-	for (HGVertex& v : graph_data.vertices) v.format_coordstr();
+	{	string coordbuf;
+		for (HGVertex& v : graph_data.vertices) v.format_coordstr(coordbuf);
+		HGVertex::pool_coordstrs(graph_data.vertices, &coordbuf, 1);
+	}
       #endif
 
+	for (GraphListEntry& g : GraphListEntry::entries)
+	  if (g.placeradius)
+	  {	cout << et.et() << "Grouping vertices by quadtree node for place radius searches." << endl;
+		PlaceRadius::setup(&all_waypoints);
+		break;
+	  }
+
+	if (Args::adjacency)
+	{	cout << et.et() << "Building & writing master graph CSR adjacency." << endl;
+		graph_data.build_csr();
+		for (int f = 0; f < 3; f++)
+		{ if (!graph_data.csr[f].write(Args::graphfilepath+'/'+GraphListEntry::entries[f].stem()+".csr"))
+			cout << "ERROR: unable to write " << GraphListEntry::entries[f].stem() << ".csr" << endl;
+		  graph_data.csr[f].clear();
+		}
+	}
+
+	if (!Args::prevgraphpath.empty())
+	{	cout << et.et() << "Reading graph manifest from " << Args::prevgraphpath << '.' << endl;
+		TMGWriter::read_manifest();
+	}
+
 	cout << et.et() << "Writing master TM graph files." << endl;
 	// print summary info
 	std::cout << "   Simple graph has " << graph_data.vertices.size() << " vertices, " << graph_data.se << " edges." << std::endl;
@@ -28,20 +56,49 @@ graph_data.waypoint_naming_log.clear();
 
 	// write graph vector entries to disk
       #ifdef threading_enabled
-	thr[0] = thread(MasterTmgThread, &graph_data, &list_mtx, &term_mtx, &all_waypoints, &et);
-	// start at t=1, because MasterTmgThread will spawn another SubgraphThread when finished
-	for (unsigned int t = 1; t < thr.size(); t++)
-	  thr[t] = thread(SubgraphThread, t, &list_mtx, &term_mtx, &graph_data, &all_waypoints, &et);
+	GraphListEntry::schedule(graph_data.vertices.size() + graph_data.se, Args::numthreads);
+	GraphListEntry::num = 0;
+	for (auto& task : GraphListEntry::tasks)
+	  if (task.first) graph_data.ve_expect(task.first);
+	THREADLOOP thr[t] = thread(SubgraphThread, t, &list_mtx, &term_mtx, &graph_data, &all_waypoints, &et);
 	THREADLOOP thr[t].join();
       #else
-	HGVertex::vnums = new int[graph_data.vertices.size()*3];
-	for (	graph_data.write_master_graphs_tmg();
+	for (size_t i = 3; i < GraphListEntry::entries.size(); i += 3) graph_data.ve_expect(i);
+	for (	graph_data.write_master_graphs_tmg(GraphListEntry::all_formats());
 		GraphListEntry::num < GraphListEntry::entries.size();
 		GraphListEntry::num += 3
-	    )	graph_data.write_subgraphs_tmg(GraphListEntry::num, 0, &all_waypoints, &et, &term_mtx);
-	delete[] HGVertex::vnums;
+	    )	graph_data.write_subgraphs_tmg(GraphListEntry::num, GraphListEntry::all_formats(), &all_waypoints, &et, &term_mtx);
       #endif
 	cout << '!' << endl;
+	if (!Args::prevgraphpath.empty())
+	{	cout << et.et() << TMGWriter::unchanged << " graph files unchanged & linked from "
+		     << Args::prevgraphpath << ". Writing graph manifest." << endl;
+		TMGWriter::write_manifest();
+	}
+	if (Args::graphstats)
+	{	cout << et.et() << "Writing graph statistics." << endl;
+		ofstream csv(Args::graphfilepath+"/graphstats.csv");
+		csv << "filename;descr;vertices;edges;travelers;format;category;"
+		       "maxDegree;avgDegree;aspectRatio;components;north;south;east;west;degreeCounts\n";
+		for (GraphListEntry& g : GraphListEntry::entries)
+		{	csv << g.filename() << ';' << g.descr << ';' << g.vertices << ';' << g.edges << ';'
+			    << g.travelers << ';' << g.format() << ';' << g.category() << ';';
+			g.stats.write_csv(csv);
+			csv << '\n';
+			if (Args::intonlygraphs && g.form == 'c')
+			{	csv << g.intonly_filename() << ';' << g.descr << ';' << g.intonly_stats.num_vertices << ';'
+				    << g.intonly_stats.num_edges << ";0;" << g.format() << ';' << g.category() << ';';
+				g.intonly_stats.write_csv(csv);
+				csv << '\n';
+			}
+		}
+	}
+	for (auto g = GraphListEntry::entries.begin(); g < GraphListEntry::entries.end(); g += 3)
+	{	delete g->regions;
+		delete g->systems;
+		delete g->placeradius;
+	}
+	PlaceRadius::clear();
 } //*/
 
 cout << et.et() << "Clearing HighwayGraph contents from memory." << endl;
@@ -5,9 +5,8 @@
       #else
 	for (HighwaySystem& h : HighwaySystem::syslist)
 	{	std::cout << h.systemname << ' ' << std::flush;
-		bool usa_flag = h.country->first == "USA";
 		for (Route& r : h.routes)
-			r.read_wpt(&all_waypoints, &el, usa_flag);
+			r.read_wpt(&all_waypoints, &el);
 		//std::cout << "!" << std::endl;
 	}
       #endif
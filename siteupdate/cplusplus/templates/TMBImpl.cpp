@@ -0,0 +1,209 @@
+// Bitwise kernels for TMBitset<item, uint64_t>, in scalar, AVX2 & AVX-512 versions,
+// and hex encoding for TMBitset<item, uint32_t>, in scalar & BMI2 versions.
+// The fastest version this CPU supports is selected once at startup, with the scalar
+// version as fallback on other CPUs, other architectures & other compilers.
+#include "TMBitset.cpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TMB_X86
+#include <immintrin.h>
+#endif
+
+// scalar
+
+static void oreq_scalar(uint64_t* a, const uint64_t* b, size_t units)
+{	for (uint64_t *end = a+units; a < end; *a++ |= *b++);
+}
+
+static void andeq_scalar(uint64_t* a, const uint64_t* b, size_t units)
+{	for (uint64_t *end = a+units; a < end; *a++ &= *b++);
+}
+
+static size_t popcount_scalar(const uint64_t* d, size_t units)
+{	size_t count = 0;
+	for (const uint64_t *end = d+units; d < end; ++d)
+		count += __builtin_popcountll(*d);
+	return count;
+}
+
+// write base + i*stride for each index i of a 1 bit in word w, which holds indices [i, i+64)
+static inline uintptr_t* extract_word(uint64_t w, uintptr_t i, uintptr_t base, size_t stride, uintptr_t* out)
+{	for (; w; w &= w-1)
+		*out++ = base + (i + __builtin_ctzll(w)) * stride;
+	return out;
+}
+
+static size_t extract_scalar(const uint64_t* d, size_t len, uintptr_t base, size_t stride, uintptr_t* out)
+{	uintptr_t* const begin = out;
+	for (size_t u = 0; u < len/64; ++u)
+		out = extract_word(d[u], u*64, base, stride, out);
+	if (len%64) // last partial unit, sans end() bit
+		out = extract_word(d[len/64] & (((uint64_t)1 << len%64) - 1), len & ~size_t(63), base, stride, out);
+	return out-begin;
+}
+
+#ifdef TMB_X86
+
+// AVX2
+
+__attribute__((target("avx2"))) static void oreq_avx2(uint64_t* a, const uint64_t* b, size_t units)
+{	uint64_t* const end = a+units;
+	for (; a+4 <= end; a += 4, b += 4)
+		_mm256_storeu_si256((__m256i*)a, _mm256_or_si256(_mm256_loadu_si256((__m256i*)a), _mm256_loadu_si256((const __m256i*)b)));
+	while (a < end) *a++ |= *b++;
+}
+
+__attribute__((target("avx2"))) static void andeq_avx2(uint64_t* a, const uint64_t* b, size_t units)
+{	uint64_t* const end = a+units;
+	for (; a+4 <= end; a += 4, b += 4)
+		_mm256_storeu_si256((__m256i*)a, _mm256_and_si256(_mm256_loadu_si256((__m256i*)a), _mm256_loadu_si256((const __m256i*)b)));
+	while (a < end) *a++ &= *b++;
+}
+
+// 4-bit lookup table via vpshufb, summed by vpsadbw
+__attribute__((target("avx2"))) static size_t popcount_avx2(const uint64_t* d, size_t units)
+{	const __m256i lut = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+					     0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+	const __m256i lo4 = _mm256_set1_epi8(0x0f);
+	__m256i acc = _mm256_setzero_si256();
+	const uint64_t* const end = d+units;
+	for (; d+4 <= end; d += 4)
+	{	__m256i v = _mm256_loadu_si256((const __m256i*)d);
+		__m256i c = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, lo4)),
+					    _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), lo4)));
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(c, _mm256_setzero_si256()));
+	}
+	size_t count = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+		     + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+	return count + popcount_scalar(d, end-d);
+}
+
+// AVX-512
+
+__attribute__((target("avx512f"))) static void oreq_avx512(uint64_t* a, const uint64_t* b, size_t units)
+{	uint64_t* const end = a+units;
+	for (; a+8 <= end; a += 8, b += 8)
+		_mm512_storeu_si512(a, _mm512_or_si512(_mm512_loadu_si512(a), _mm512_loadu_si512(b)));
+	if (__mmask8 m = (1 << (end-a)) - 1)
+		_mm512_mask_storeu_epi64(a, m, _mm512_or_si512(_mm512_maskz_loadu_epi64(m, a), _mm512_maskz_loadu_epi64(m, b)));
+}
+
+__attribute__((target("avx512f"))) static void andeq_avx512(uint64_t* a, const uint64_t* b, size_t units)
+{	uint64_t* const end = a+units;
+	for (; a+8 <= end; a += 8, b += 8)
+		_mm512_storeu_si512(a, _mm512_and_si512(_mm512_loadu_si512(a), _mm512_loadu_si512(b)));
+	if (__mmask8 m = (1 << (end-a)) - 1)
+		_mm512_mask_storeu_epi64(a, m, _mm512_and_si512(_mm512_maskz_loadu_epi64(m, a), _mm512_maskz_loadu_epi64(m, b)));
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq"))) static size_t popcount_avx512(const uint64_t* d, size_t units)
+{	__m512i acc = _mm512_setzero_si512();
+	const uint64_t* const end = d+units;
+	for (; d+8 <= end; d += 8)
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(d)));
+	if (__mmask8 m = (1 << (end-d)) - 1)
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(m, d)));
+	// sum the lanes by hand; GCC's own reductions use an uninitialized operand & warn
+	uint64_t lanes[8];
+	_mm512_storeu_si512(lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+}
+
+// Each byte of the set is a mask selecting which of 8 consecutive
+// items to compress together & store contiguously to out.
+__attribute__((target("avx512f"))) static uintptr_t* extract_word_avx512
+(	uint64_t w, uintptr_t i, uintptr_t base, const __m512i& steps, size_t stride, uintptr_t* out)
+{	for (; w; w >>= 8, i += 8)
+	  if (__mmask8 m = w)
+	  {	__m512i v = _mm512_add_epi64(_mm512_set1_epi64(base + i*stride), steps);
+		int n = __builtin_popcount(m);
+		_mm512_mask_storeu_epi64(out, (1 << n) - 1, _mm512_maskz_compress_epi64(m, v));
+		out += n;
+	  }
+	return out;
+}
+
+__attribute__((target("avx512f"))) static size_t extract_avx512(const uint64_t* d, size_t len, uintptr_t base, size_t stride, uintptr_t* out)
+{	uintptr_t* const begin = out;
+	const __m512i steps = _mm512_setr_epi64(0, stride, 2*stride, 3*stride, 4*stride, 5*stride, 6*stride, 7*stride);
+	for (size_t u = 0; u < len/64; ++u)
+		out = extract_word_avx512(d[u], u*64, base, steps, stride, out);
+	if (len%64) // last partial unit, sans end() bit
+		out = extract_word_avx512(d[len/64] & (((uint64_t)1 << len%64) - 1), len & ~size_t(63), base, steps, stride, out);
+	return out-begin;
+}
+
+#endif
+
+// hex codes of bits selected by a mask, for TMBitset<item, uint32_t>::hex_code
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+// append the k low bits of bits to the 4*n+k bits pending in acc, & write out whole digits
+static inline char* emit(uint64_t& acc, unsigned& n, uint64_t bits, unsigned k, char* out)
+{	acc |= bits << n;
+	for (n += k; n >= 4; n -= 4, acc >>= 4) *out++ = hex_digits[acc & 15];
+	return out;
+}
+
+static inline uint32_t pext_scalar(uint32_t w, uint32_t m)
+{	uint32_t bits = 0;
+	for (uint32_t b = 1; m; m &= m-1, b <<= 1)
+	  if (w & m & -m) bits |= b;
+	return bits;
+}
+
+static char* hex_pext_scalar(const uint32_t* w, const uint32_t* m, size_t len, char* out)
+{	uint64_t acc = 0;
+	unsigned n = 0;
+	size_t const units = len/32;
+	uint32_t const last = ((uint32_t)1 << len%32) - 1; // sans end() bit
+	if (!m)
+	{	for (size_t u = 0; u < units; ++u) out = emit(acc, n, w[u], 32, out);
+		out = emit(acc, n, w[units] & last, len%32, out);
+	}
+	else {	for (size_t u = 0; u < units; ++u) out = emit(acc, n, pext_scalar(w[u], m[u]), __builtin_popcount(m[u]), out);
+		out = emit(acc, n, pext_scalar(w[units], m[units] & last), __builtin_popcount(m[units] & last), out);
+	     }
+	if (n) *out++ = hex_digits[acc & 15];
+	return out;
+}
+
+#ifdef TMB_X86
+__attribute__((target("bmi2"))) static char* hex_pext_bmi2(const uint32_t* w, const uint32_t* m, size_t len, char* out)
+{	if (!m) return hex_pext_scalar(w, m, len, out);
+	uint64_t acc = 0;
+	unsigned n = 0;
+	size_t const units = len/32;
+	uint32_t const last = ((uint32_t)1 << len%32) - 1; // sans end() bit
+	for (size_t u = 0; u < units; ++u) out = emit(acc, n, _pext_u32(w[u], m[u]), __builtin_popcount(m[u]), out);
+	out = emit(acc, n, _pext_u32(w[units], m[units] & last), __builtin_popcount(m[units] & last), out);
+	if (n) *out++ = hex_digits[acc & 15];
+	return out;
+}
+#endif
+
+// dispatch
+// No TMBitsets are operated on before main(), so static initialization order is no concern.
+
+#ifdef TMB_X86
+#define CPU(feature) (__builtin_cpu_init(), __builtin_cpu_supports(feature))
+#define PICK(k, avx512_ok) (avx512_ok ? k##_avx512 : CPU("avx2") ? k##_avx2 : k##_scalar)
+void   (*TMBImpl<uint64_t>::bitwise_oreq) (uint64_t*, const uint64_t*, size_t) = PICK(oreq,  CPU("avx512f"));
+void   (*TMBImpl<uint64_t>::bitwise_andeq)(uint64_t*, const uint64_t*, size_t) = PICK(andeq, CPU("avx512f"));
+size_t (*TMBImpl<uint64_t>::popcount)(const uint64_t*, size_t) = PICK(popcount, CPU("avx512f") && CPU("avx512vpopcntdq"));
+// AVX2 has no compress instruction; its scalar ctz loop is as good as anything it could do
+size_t (*TMBImpl<uint64_t>::extract)(const uint64_t*, size_t, uintptr_t, size_t, uintptr_t*)
+	= CPU("avx512f") ? extract_avx512 : extract_scalar;
+// pext is microcoded & slow on AMD before Zen 3
+char* (*TMBImpl<uint32_t>::hex_pext)(const uint32_t*, const uint32_t*, size_t, char*)
+	= CPU("bmi2") && !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2") ? hex_pext_bmi2 : hex_pext_scalar;
+#undef PICK
+#undef CPU
+#else
+void   (*TMBImpl<uint64_t>::bitwise_oreq) (uint64_t*, const uint64_t*, size_t) = oreq_scalar;
+void   (*TMBImpl<uint64_t>::bitwise_andeq)(uint64_t*, const uint64_t*, size_t) = andeq_scalar;
+size_t (*TMBImpl<uint64_t>::popcount)(const uint64_t*, size_t) = popcount_scalar;
+size_t (*TMBImpl<uint64_t>::extract)(const uint64_t*, size_t, uintptr_t, size_t, uintptr_t*) = extract_scalar;
+char* (*TMBImpl<uint32_t>::hex_pext)(const uint32_t*, const uint32_t*, size_t, char*) = hex_pext_scalar;
+#endif
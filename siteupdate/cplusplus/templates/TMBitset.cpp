@@ -5,9 +5,12 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 template <class unit> struct TMBImpl;
+template <class item> class TMRoaring;
 
 template <class item, class unit> class TMBitset
 {	size_t units;
@@ -45,6 +48,86 @@ template <class item, class unit> class TMBitset
 		data[units-1] |= (unit)1 << len%ubits;
 	}
 
+	// Does not free resources. Only call on unallocated objects.
+	// Set to the union of n sets & m compressed sets, allocating once & in one pass over all of them.
+	// All must be from the same array, with sets aligned to a unit boundary relative to its start,
+	// as unions of compressed sets are.
+	void assign_union(const TMBitset<item,unit>* const* sets, size_t const n, const TMRoaring<item>* const* rsets, size_t const m)
+	{	units=1; len=0; start=0;
+		data=(unit*)&null_datum;
+		item lo = 0, hi = 0;
+		auto extend = [&](item const l, item const h)
+		{	if (!len || l < lo) lo = l;
+			if (!len || h > hi) hi = h;
+			len = 1; // at least one set isn't empty
+		};
+		for (size_t i = 0; i < n; ++i)
+		  if (sets[i]->len) extend(sets[i]->start, sets[i]->start+sets[i]->len);
+		for (size_t i = 0; i < m; ++i)
+		  if (!rsets[i]->is_null_set())
+		    extend(rsets[i]->base + (rsets[i]->lo_index() & ~(ubits-1)), rsets[i]->base + rsets[i]->hi_index());
+		if (!len) return;
+		start = lo;
+		len = hi - lo;
+		units = ceil(double(len+1)/ubits);
+		data = (unit*)calloc(units, sizeof(unit));
+		for (size_t i = 0; i < n; ++i)
+		  if (sets[i]->len)
+		  {	const TMBitset<item,unit>& b = *sets[i];
+			if ((b.start-start) % ubits) throw std::make_pair(this, &b);
+			unit* const d = data + (b.start-start)/ubits;
+			TMBImpl<unit>::bitwise_oreq(d, b.data, b.units-1);
+			d[b.units-1] |= b.data[b.units-1] ^ (unit)1 << b.len%ubits; // sans end() bit
+		  }
+		for (size_t i = 0; i < m; ++i)
+		  if (!rsets[i]->is_null_set()) rsets[i]->or_into(data, start - rsets[i]->base);
+		//create dummy end() item
+		data[units-1] |= (unit)1 << len%ubits;
+	}
+
+	// As above, for n sets or n compressed sets alone
+	void assign_union(const TMBitset<item,unit>* const* sets, size_t const n)
+	{	assign_union(sets, n, (const TMRoaring<item>* const*)0, 0);
+	}
+	void assign_union(const TMRoaring<item>* const* sets, size_t const n)
+	{	assign_union((const TMBitset<item,unit>* const*)0, 0, sets, n);
+	}
+
+	// Does not free resources. Only call on unallocated objects.
+	// Set to the intersection of n sets, allocating once & in one pass over all of them.
+	void assign_intersection(const TMBitset<item,unit>* const* sets, size_t const n)
+	{	units=1; len=0; start=0;
+		data=(unit*)&null_datum;
+		item lo = sets[0]->start;
+		item hi = sets[0]->start+sets[0]->len;
+		for (size_t i = 0; i < n; ++i)
+		{	if (!sets[i]->len) return;
+			if (sets[i]->start > lo) lo = sets[i]->start;
+			if (sets[i]->start+sets[i]->len < hi) hi = sets[i]->start+sets[i]->len;
+		}
+		if (hi <= lo) return;
+		start = lo;
+		len = hi - lo;
+		units = ceil(double(len+1)/ubits);
+		data = (unit*)malloc(units*sizeof(unit));
+		for (size_t i = 0; i < n; ++i)
+		{	const TMBitset<item,unit>& b = *sets[i];
+			if ((start-b.start) % ubits) throw std::make_pair(this, &b);
+			if (i)	TMBImpl<unit>::bitwise_andeq(data, b.data + (start-b.start)/ubits, units);
+			else	memcpy(data, b.data + (start-b.start)/ubits, units*sizeof(unit));
+		}
+		// clear everything from the end() item up, then recreate it
+		data[units-1] &= ((unit)1 << len%ubits) - 1;
+		data[units-1] |= (unit)1 << len%ubits;
+	}
+
+	void swap(TMBitset<item,unit>& other)
+	{	std::swap(units, other.units);
+		std::swap(len,   other.len);
+		std::swap(start, other.start);
+		std::swap(data,  other.data);
+	}
+
 	// Don't clear null sets; there's nothing to free.
 	void clear()
 	{	units=1; len=0; start=0;
@@ -64,6 +147,13 @@ template <class item, class unit> class TMBitset
 	// For use when both sets' start & len are known to match, e.g. HighwaySegmwent::clinched_by
 	void fast_union(const TMBitset<item,unit>& other) {TMBImpl<unit>::bitwise_oreq(data, other.data, units);}
 
+	// Write this set's bits as hex digits, 4 per digit, low bit first.
+	// If mask is given, only the bits at its 1 bits' positions, packed together;
+	// its start & len must match. Return one past the last digit written.
+	char* hex_code(char* out, const TMBitset<item,unit>* mask) const
+	{	return TMBImpl<unit>::hex_pext(data, mask ? mask->data : 0, len, out);
+	}
+
 	// return an end() index (one past the last 1 bit in the set) for shrink_to_fit()
 	size_t end_index() const
 	{	long u = units-1;
@@ -89,11 +179,29 @@ template <class item, class unit> class TMBitset
 
 		memcpy(data, old_data+lo_index/ubits, units*sizeof(unit));
 		free(old_data);
-		//create dummy end() item
+		// clear everything from the new end() item up, old end() item included, then recreate it
+		data[units-1] &= ((unit)1 << len%ubits) - 1;
 		data[units-1] |= (unit)1 << len%ubits;
 	}
 
 	bool operator [] (const size_t index) const {return data[index/ubits] & (unit)1 << index%ubits;}
+	bool has_value(item const value) const {return (*this)[value-start];}
+
+	// number of items in the set before each unit, for rank()
+	std::vector<uint32_t> rank_table() const
+	{	std::vector<uint32_t> r(units);
+		uint32_t n = 0;
+		for (size_t u = 0; u < units; ++u)
+		{	r[u] = n;
+			n += __builtin_popcountll(data[u]);
+		}
+		return r;
+	}
+	// number of items in the set before value, which must be in range, per a rank_table
+	size_t rank(const std::vector<uint32_t>& r, item const value) const
+	{	size_t const index = value-start;
+		return r[index/ubits] + __builtin_popcountll(data[index/ubits] & (((unit)1 << index%ubits) - 1));
+	}
 
 	// The != operator assumes both objects have the same start & length, and shall only be used in this context.
 	bool operator != (const TMBitset<item,unit>& other) const {return memcmp(data, other.data, units*sizeof(unit));}
@@ -219,15 +327,17 @@ template <class item, class unit> class TMBitset
 	}
 	iterator<size_t> iend() const {return iterator<size_t>(data, 0, len);}
 
+	// Write every item in the set to out, which must have room for count() of them,
+	// a block at a time rather than iterating bit by bit. Return the number written.
+	size_t extract(item* out) const
+	{	return TMBImpl<unit>::extract(data, len, (uintptr_t)start,
+			sizeof(typename std::remove_pointer<item>::type), (uintptr_t*)out);
+	}
+
 	// diagnostics, debug, etc.
 	bool is_null_set() {return data == &null_datum;}
 
-	size_t count()
-	{	size_t count = 0;
-		for (unit *d = data, *e = d+units; d < e; ++d)
-			count += __builtin_popcountl(*d);
-		return	count-1;
-	}
+	size_t count() const {return TMBImpl<unit>::popcount(data, units)-1;}
 
 	size_t heap()	  {return sizeof(unit) * units;}
 	size_t vec_size() {return sizeof(item) * count();}
@@ -242,22 +352,27 @@ template <class item, class unit> class TMBitset
 // Not necessary under C++17; just use a constexpr
 template <class item, class unit> const unit TMBitset<item, unit>::null_datum = 1;
 
-template <> struct TMBImpl<uint32_t>
-{	static void bitwise_oreq(uint32_t* a, const uint32_t* const b, size_t units)
-	{	uint64_t *end = (uint64_t*)(a+units)-1;
-		uint64_t *d64 = (uint64_t*)a;
-		uint64_t *o64 = (uint64_t*)b;
-		while (d64 <= end) *d64++ |= *o64++;
-		if (units & 1) *(uint32_t*)d64 |= *(uint32_t*)o64;
-	}
+// Defined in TMBImpl.cpp, pointing to the scalar, AVX2 or
+// AVX-512 versions, whichever is fastest on this CPU.
+template <> struct TMBImpl<uint64_t>
+{	static void   (*bitwise_oreq) (uint64_t*, const uint64_t*, size_t);
+	static void   (*bitwise_andeq)(uint64_t*, const uint64_t*, size_t);
+	static size_t (*popcount)(const uint64_t*, size_t);
+	// write base + i*stride for each index i of a 1 bit in the first len bits
+	static size_t (*extract)(const uint64_t*, size_t len, uintptr_t base, size_t stride, uintptr_t*);
 };
 
-template <> struct TMBImpl<uint64_t>
-{	static void bitwise_oreq(uint64_t* a, const uint64_t* b, size_t units)
-	{	for (uint64_t *end = a+units; a < end; *a++ |= *b++);
+template <> struct TMBImpl<uint32_t>
+{	// Defined in TMBImpl.cpp, using BMI2 pext where it's fast, else a scalar version
+	static char* (*hex_pext)(const uint32_t*, const uint32_t*, size_t len, char*);
+
+	static void bitwise_oreq(uint32_t* a, const uint32_t* const b, size_t units)
+	{	TMBImpl<uint64_t>::bitwise_oreq((uint64_t*)a, (const uint64_t*)b, units/2);
+		if (units & 1) a[units-1] |= b[units-1];
 	}
-	static void bitwise_andeq(uint64_t* a, const uint64_t* b, size_t units)
-	{	for (uint64_t *end = a+units; a < end; *a++ &= *b++);
+	static size_t popcount(const uint32_t* d, size_t units)
+	{	return	TMBImpl<uint64_t>::popcount((const uint64_t*)d, units/2)
+		      + (units & 1 ? __builtin_popcount(d[units-1]) : 0);
 	}
 };
 #endif
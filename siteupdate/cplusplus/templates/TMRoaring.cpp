@@ -0,0 +1,231 @@
+#ifndef TMROARING
+#define TMROARING
+
+#include "TMBitset.cpp"
+#include <vector>
+
+template <class item> class TMRoaring
+{   /* Compressed set of items from a contiguous array, for sets that are
+    sparse within their span, e.g. per-region & per-system vertex & edge
+    sets. Items are grouped by index into chunks of 2^16. Each nonempty
+    chunk is stored in whichever container is smallest for its contents:
+      ARRAY:  sorted 16-bit indices, for sparse chunks
+      BITMAP: 64-bit units as in a TMBitset, spanning only
+	      the chunk's 1st thru last items, for dense chunks
+      RUNS:   16-bit (start, length-1) pairs, for long consecutive stretches
+    Built from a TMBitset once populated, and read-only thereafter.
+    Iterates, counts & unions into a TMBitset like a TMBitset.
+    */
+	enum : uint8_t {ARRAY, BITMAP, RUNS};
+	struct Container
+	{	uint32_t key;	// chunk number; index >> 16
+		uint8_t  type;
+		uint16_t lo_unit;// BITMAP: chunk's unit stored first
+		uint32_t card;	// number of items
+		uint32_t size;	// ARRAY: indices; RUNS: runs; BITMAP: units
+		uint16_t* data;	// uint64_t units for a BITMAP
+	};
+	Container* cont;
+	size_t n;
+	item base;
+
+	template <class, class> friend class TMBitset;
+
+	void add_container(std::vector<Container>& v, uint32_t key, const std::vector<uint16_t>& vals)
+	{	Container c;
+		c.key = key;
+		c.card = vals.size();
+		uint32_t runs = 1;
+		for (size_t i = 1; i < vals.size(); ++i)
+		  if (vals[i] != vals[i-1]+1) runs++;
+		size_t const array_bytes = 2*vals.size();
+		size_t const runs_bytes  = 4*runs;
+		size_t const bitmap_bytes = 8*(vals.back()/64 - vals.front()/64 + 1);
+		if (runs_bytes < array_bytes && runs_bytes < bitmap_bytes)
+		     {	c.type = RUNS;
+			c.size = runs;
+			c.data = (uint16_t*)malloc(runs_bytes);
+			uint16_t* d = c.data;
+			for (size_t i = 0; i < vals.size(); ++i)
+			  if (!i || vals[i] != vals[i-1]+1)
+			  {	*d++ = vals[i];
+				*d++ = 0;
+			  }
+			  else	d[-1]++;
+		     }
+		else if (array_bytes <= bitmap_bytes)
+		     {	c.type = ARRAY;
+			c.size = vals.size();
+			c.data = (uint16_t*)malloc(array_bytes);
+			memcpy(c.data, vals.data(), array_bytes);
+		     }
+		else {	c.type = BITMAP;
+			c.lo_unit = vals.front()/64;
+			c.size = bitmap_bytes/8;
+			c.data = (uint16_t*)calloc(bitmap_bytes, 1);
+			uint64_t* u = (uint64_t*)c.data - c.lo_unit;
+			for (uint16_t i : vals) u[i/64] |= (uint64_t)1 << i%64;
+		     }
+		v.push_back(c);
+	}
+
+	// index within a container's chunk of its first item, and one past its last
+	static size_t first(const Container& c)
+	{	if (c.type != BITMAP) return c.data[0];
+		return c.lo_unit*64 + __builtin_ctzll(*(const uint64_t*)c.data);
+	}
+	static size_t past_last(const Container& c)
+	{	switch (c.type)
+		{ case ARRAY:	return c.data[c.size-1] + 1;
+		  case RUNS:	return c.data[2*c.size-2] + c.data[2*c.size-1] + 1;
+		}
+		return (c.lo_unit+c.size)*64 - __builtin_clzll(((const uint64_t*)c.data)[c.size-1]);
+	}
+
+	public:
+	TMRoaring(): cont(0), n(0), base(0) {}
+	TMRoaring(const TMRoaring<item>&) = delete;
+	~TMRoaring() {clear();}
+
+	void clear()
+	{	for (size_t i = 0; i < n; ++i) free(cont[i].data);
+		free(cont);
+		cont = 0;
+		n = 0;
+	}
+
+	// Set to the contents of s, whose items are from an array beginning at b.
+	template <class unit> void assign(const TMBitset<item,unit>& s, item const b)
+	{	clear();
+		base = b;
+		std::vector<Container> v;
+		std::vector<uint16_t> vals;
+		uint32_t key = 0;
+		for (item i : s)
+		{	size_t const index = i-base;
+			if (index >> 16 != key)
+			{	if (vals.size()) add_container(v, key, vals);
+				vals.clear();
+				key = index >> 16;
+			}
+			vals.push_back(index);
+		}
+		if (vals.size()) add_container(v, key, vals);
+		if (!(n = v.size())) return;
+		cont = (Container*)malloc(n*sizeof(Container));
+		memcpy(cont, v.data(), n*sizeof(Container));
+	}
+
+	// index of the first item, and one past the last. Not for null sets.
+	size_t lo_index() const {return (size_t(cont[0].key)   << 16) + first(cont[0]);}
+	size_t hi_index() const {return (size_t(cont[n-1].key) << 16) + past_last(cont[n-1]);}
+
+	// OR the set into units d, whose bit 0 is item index d_index, a multiple
+	// of 64, and that are large enough to hold everything from there up.
+	void or_into(uint64_t* const d, size_t const d_index) const
+	{	for (const Container *c = cont, *end = cont+n; c < end; ++c)
+		{	size_t const chunk = size_t(c->key) << 16;
+			switch (c->type)
+			{ case ARRAY:
+				for (uint16_t *v = c->data, *e = v+c->size; v < e; ++v)
+				{	size_t const i = chunk + *v - d_index;
+					d[i/64] |= (uint64_t)1 << i%64;
+				}
+				break;
+			  case RUNS:
+				for (uint16_t *r = c->data, *e = r+2*c->size; r < e; r += 2)
+				  for (size_t i = chunk + r[0] - d_index, last = i + r[1]; i <= last; ++i)
+					d[i/64] |= (uint64_t)1 << i%64;
+				break;
+			  default: // BITMAP
+				TMBImpl<uint64_t>::bitwise_oreq(d + (chunk + c->lo_unit*64 - d_index)/64, (uint64_t*)c->data, c->size);
+			}
+		}
+	}
+
+	class iterator
+	{	const Container *c, *end;
+		uint32_t pos;	// ARRAY: index; RUNS: item number within run; BITMAP: unit
+		uint32_t run;	// RUNS: run number
+		uint64_t bits;	// BITMAP: remaining bits of current unit
+		item base, val;
+
+		void load()
+		{	pos = run = 0;
+			if (c == end) {val = 0; return;}
+			if (c->type == BITMAP)
+			{	bits = *(uint64_t*)c->data;
+				advance_bitmap();
+			}
+			else	val = base + (size_t(c->key) << 16 | c->data[0]);
+		}
+		void advance_bitmap()
+		{	const uint64_t* u = (const uint64_t*)c->data;
+			while (!bits)
+			  if (++pos == c->size) {++c; return load();}
+			  else bits = u[pos];
+			val = base + (size_t(c->key) << 16 | ((c->lo_unit+pos)*64 + __builtin_ctzll(bits)));
+		}
+
+		public:
+		iterator(const Container* const b, const Container* const e, item const s): c(b), end(e), base(s) {load();}
+
+		item operator * () const {return val;}
+
+		void operator ++ ()
+		{	switch (c->type)
+			{ case ARRAY:
+				if (++pos == c->size) {++c; return load();}
+				val = base + (size_t(c->key) << 16 | c->data[pos]);
+				return;
+			  case RUNS:
+				if (pos < c->data[2*run+1]) {++pos; ++val; return;}
+				if (++run == c->size) {++c; return load();}
+				pos = 0;
+				val = base + (size_t(c->key) << 16 | c->data[2*run]);
+				return;
+			  default:
+				bits &= bits-1;
+				advance_bitmap();
+			}
+		}
+
+		bool operator != (const iterator& other) const {return c != other.c || val != other.val;}
+	};
+
+	iterator begin() const {return iterator(cont, cont+n, base);}
+	iterator end()   const {return iterator(cont+n, cont+n, base);}
+
+	bool is_null_set() const {return !n;}
+
+	size_t count() const
+	{	size_t count = 0;
+		for (size_t i = 0; i < n; ++i) count += cont[i].card;
+		return count;
+	}
+
+	size_t heap() const
+	{	size_t heap = n*sizeof(Container);
+		for (size_t i = 0; i < n; ++i)
+		  switch (cont[i].type)
+		  {	case ARRAY:  heap += 2*cont[i].size; break;
+			case RUNS:   heap += 4*cont[i].size; break;
+			case BITMAP: heap += 8*cont[i].size;
+		  }
+		return heap;
+	}
+	// heap size of the same set as a shrunk-to-fit TMBitset
+	size_t tmb_heap() const
+	{	if (!n) return sizeof(uint64_t);
+		size_t const len = hi_index() - (lo_index() & ~size_t(63));
+		return sizeof(uint64_t) * ((len+64)/64);
+	}
+	size_t vec_size() const {return sizeof(item) * count();}
+	size_t vec_cap() const
+	{	size_t c = count();
+		size_t res = c & size_t(-1) << (63-__builtin_clzl(c));
+		if (c^res) res <<= 1;
+		return sizeof(item) * res;
+	}
+};
+#endif
@@ -8,7 +8,6 @@ void ReadWptThread(unsigned int id, std::mutex* mtx, ErrorList* el,WaypointQuadt
 		mtx->unlock();
 
 		std::cout << h->systemname << ' ' << std::flush;
-		bool usa_flag = h->country->first == "USA";
 		Region* prev_region = nullptr;
 		for (Route& r : h->routes)
 		{	// create key/value pairs in h->mileage_by_region, to be computed in a threadsafe manner later
@@ -16,7 +15,7 @@ void ReadWptThread(unsigned int id, std::mutex* mtx, ErrorList* el,WaypointQuadt
 			{	h->mileage_by_region[r.region];
 				prev_region = r.region;
 			}
-			r.read_wpt(all_waypoints, el, usa_flag);
+			r.read_wpt(all_waypoints, el);
 		}
 		//std::cout << "!" << std::endl;
 	}
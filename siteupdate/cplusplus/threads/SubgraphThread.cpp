@@ -3,19 +3,16 @@ void SubgraphThread
 	HighwayGraph* graph_data, WaypointQuadtree* qt, ElapsedTime* et
 )
 {	//std::cout << "Starting SubgraphThread " << id << std::endl;
-	HGVertex::vnums = new int[graph_data->vertices.size()*3];
-	while (GraphListEntry::num < GraphListEntry::entries.size())
+	while (GraphListEntry::num < GraphListEntry::tasks.size())
 	{	l->lock();
-		if (GraphListEntry::num >= GraphListEntry::entries.size())
+		if (GraphListEntry::num >= GraphListEntry::tasks.size())
 		{	l->unlock();
-			return;
+			break;
 		}
-		//std::cout << "Thread " << id << " with graph_vector.size()=" << graph_vector->size() << " & index=" << GraphListEntry::num << std::endl;
-		//std::cout << "Thread " << id << " assigned " << GraphListEntry::entries.at(GraphListEntry::num).tag() << std::endl;
-		size_t i = GraphListEntry::num;
-		GraphListEntry::num += 3;
+		//std::cout << "Thread " << id << " assigned " << GraphListEntry::entries.at(GraphListEntry::tasks[GraphListEntry::num].first).tag() << std::endl;
+		std::pair<size_t, unsigned char> task = GraphListEntry::tasks[GraphListEntry::num++];
 		l->unlock();
-		graph_data->write_subgraphs_tmg(i, id, qt, et, t);
+		if (task.first) graph_data->write_subgraphs_tmg(task.first, task.second, qt, et, t);
+		else		graph_data->write_master_graphs_tmg(task.second);
 	}
-	delete[] HGVertex::vnums;
 }
@@ -1,4 +1,6 @@
-void VtxFmtThread(unsigned int id, std::vector<HGVertex>* vertices)
-{	for (auto v = vertices->begin()+id, end = vertices->end(); v < end; v += Args::numthreads)
-		v->format_coordstr();
+void VtxFmtThread(unsigned int id, std::vector<HGVertex>* vertices, std::string* buf)
+{	// format an equal chunk of vertices into buf, for HGVertex::pool_coordstrs
+	for (auto v = vertices->begin()+id*vertices->size()/Args::numthreads,
+		end = vertices->begin()+(id+1)*vertices->size()/Args::numthreads; v < end; v++)
+		v->format_coordstr(*buf);
 }
@@ -14,7 +14,6 @@
 
 #include "CompStatsThread.cpp"
 #include "ConcAugThread.cpp"
-#include "MasterTmgThread.cpp"
 #include "NmpMergedThread.cpp"
 #include "NmpSearchThread.cpp"
 #include "ReadListThread.cpp"
@@ -8,7 +8,6 @@ class WaypointQuadtree;
 
 void CompStatsThread (unsigned int, std::mutex*);
 void ConcAugThread   (unsigned int, std::mutex*, std::vector<std::string>*);
-void MasterTmgThread(HighwayGraph*, std::mutex*, std::mutex*, WaypointQuadtree*, ElapsedTime*);
 void NmpMergedThread (unsigned int, std::mutex*);
 void NmpSearchThread (unsigned int, std::mutex*, WaypointQuadtree*);
 void ReadListThread  (unsigned int, std::mutex*, ErrorList*);
@@ -17,4 +16,4 @@ void RteIntThread    (unsigned int, std::mutex*, ErrorList*);
 void StatsCsvThread  (unsigned int, std::mutex*);
 void SubgraphThread  (unsigned int, std::mutex*, std::mutex*, HighwayGraph*, WaypointQuadtree*, ElapsedTime*);
 void UserLogThread   (unsigned int, std::mutex*, const double, const double);
-void VtxFmtThread    (unsigned int, std::vector<HGVertex>*);
+void VtxFmtThread    (unsigned int, std::vector<HGVertex>*, std::string*);
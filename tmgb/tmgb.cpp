@@ -0,0 +1,270 @@
+#include "tmgb.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char* const format_lines[] = {"TMG 1.0 simple", "TMG 1.0 collapsed", "TMG 2.0 traveled"};
+static const char hex_digits[] = "0123456789ABCDEF";
+
+static size_t pad8(size_t n) {return (n+7) & ~size_t(7);}
+
+// TMGBFile
+
+TMGBFile::TMGBFile(): map(0), map_size(0), header(0) {}
+
+TMGBFile::~TMGBFile() {close();}
+
+void TMGBFile::close()
+{	if (map) munmap(map, map_size);
+	map = 0;
+	map_size = 0;
+	header = 0;
+}
+
+const char* TMGBFile::open(const char* filename)
+{	close();
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0) return "unable to open file";
+	struct stat st;
+	if (fstat(fd, &st) || size_t(st.st_size) < sizeof(TMGBHeader))
+	{	::close(fd);
+		return "file too small for a TMGB header";
+	}
+	map_size = st.st_size;
+	map = mmap(0, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+	{	map = 0;
+		return "unable to map file";
+	}
+	const char* const base = (const char*)map;
+	header = (const TMGBHeader*)base;
+	const TMGBHeader& h = *header;
+	#define FAIL(msg) {close(); return msg;}
+	if (memcmp(h.magic, "TMGB", 4))		FAIL("not a TMGB file");
+	if (h.version != TMGB_VERSION)		FAIL("unsupported TMGB version");
+	if (h.format > TMGB_TRAVELED)		FAIL("invalid graph format");
+	if (h.format != TMGB_TRAVELED && (h.num_travelers || h.cby_words))
+						FAIL("travelers in a graph other than traveled");
+	if (h.cby_words != (h.num_travelers+31)/32)
+						FAIL("clinched_by words don't match traveler count");
+	auto fits = [&](uint64_t offset, uint64_t bytes)
+	{	return !(offset % 8) && offset <= map_size && bytes <= map_size - offset;
+	};
+	if (!fits(h.vertices,    uint64_t(h.num_vertices)  * sizeof(TMGBVertex))
+	 || !fits(h.edges,       uint64_t(h.num_edges+1)   * sizeof(TMGBEdge))
+	 || !fits(h.points,      h.num_points	     * sizeof(TMGBPoint))
+	 || !fits(h.clinched_by, uint64_t(h.num_edges)     * h.cby_words * 4)
+	 || !fits(h.travelers,   uint64_t(h.num_travelers) * 4)
+	 || !fits(h.pool,	h.pool_size))	FAIL("section extends past end of file");
+	vertices  = (const TMGBVertex*)(base + h.vertices);
+	edges     = (const TMGBEdge*)  (base + h.edges);
+	points    = (const TMGBPoint*) (base + h.points);
+	cby	  = (const uint32_t*)  (base + h.clinched_by);
+	travelers = (const uint32_t*)  (base + h.travelers);
+	pool	  = base + h.pool;
+	if (edges[h.num_edges].points != h.num_points)
+						FAIL("edge sentinel doesn't match point count");
+	if (h.pool_size && pool[h.pool_size-1])	FAIL("string pool not NUL-terminated");
+	// every index & offset in range, for unchecked access from here on
+	for (uint32_t v = 0; v < h.num_vertices; ++v)
+	  if (vertices[v].label >= h.pool_size)	FAIL("vertex label past end of string pool");
+	for (uint32_t e = 0; e < h.num_edges; ++e)
+	{	if (edges[e].v1 >= h.num_vertices || edges[e].v2 >= h.num_vertices)
+						FAIL("edge endpoint past last vertex");
+		if (edges[e].label >= h.pool_size)	FAIL("edge label past end of string pool");
+		if (edges[e].points > edges[e+1].points)
+						FAIL("edge shaping points out of order");
+	}
+	for (uint32_t t = 0; t < h.num_travelers; ++t)
+	  if (travelers[t] >= h.pool_size)	FAIL("traveler name past end of string pool");
+	#undef FAIL
+	return 0;
+}
+
+void TMGBFile::write_text(std::ostream& out) const
+{	const TMGBHeader& h = *header;
+	char buf[64];
+	out << format_lines[h.format] << '\n' << h.num_vertices << ' ' << h.num_edges;
+	if (h.format == TMGB_TRAVELED) out << ' ' << h.num_travelers;
+	out << '\n';
+	for (uint32_t v = 0; v < h.num_vertices; ++v)
+	{	snprintf(buf, sizeof(buf), " %.15g %.15g\n", vertices[v].lat, vertices[v].lng);
+		out << vertex_label(v) << buf;
+	}
+	std::string code(h.num_travelers ? (h.num_travelers+3)/4 : 1, '0');
+	for (uint32_t e = 0; e < h.num_edges; ++e)
+	{	out << edges[e].v1 << ' ' << edges[e].v2 << ' ' << edge_label(e);
+		if (h.format == TMGB_TRAVELED)
+		{	const uint32_t* w = clinched_by(e);
+			if (h.num_travelers)
+			  for (size_t d = 0; d < code.size(); ++d)
+				code[d] = hex_digits[w[d/8] >> d%8*4 & 15];
+			out << ' ' << code;
+		}
+		for (const TMGBPoint *p = points_begin(e), *end = points_end(e); p != end; ++p)
+		{	snprintf(buf, sizeof(buf), " %.15g %.15g", p->lat, p->lng);
+			out << buf;
+		}
+		out << '\n';
+	}
+	if (h.format == TMGB_TRAVELED)
+	{	for (uint32_t t = 0; t < h.num_travelers; ++t)
+			out << traveler(t) << ' ';
+		out << '\n';
+	}
+}
+
+// TMGBBuilder
+
+TMGBBuilder::TMGBBuilder(uint32_t format, uint32_t num_travelers)
+{	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, "TMGB", 4);
+	hdr.version = TMGB_VERSION;
+	hdr.format = format;
+	if (format == TMGB_TRAVELED)
+	{	hdr.num_travelers = num_travelers;
+		hdr.cby_words = (num_travelers+31)/32;
+	}
+}
+
+uint32_t TMGBBuilder::add_string(const char* s, size_t len)
+{	uint32_t offset = pool.size();
+	pool.append(s, len);
+	pool.push_back(0);
+	return offset;
+}
+
+void TMGBBuilder::vertex(const char* label, double lat, double lng)
+{	vertices.push_back({lat, lng, add_string(label, strlen(label)), 0});
+}
+
+void TMGBBuilder::edge(uint32_t v1, uint32_t v2, const std::string& label)
+{	auto i = interned.find(label);
+	uint32_t offset = i != interned.end() ? i->second
+			: interned[label] = add_string(label.data(), label.size());
+	edges.push_back({v1, v2, offset, uint32_t(points.size())});
+	cby.resize(cby.size()+hdr.cby_words);
+}
+
+// set the last edge's clinched_by bits from its code in a .tmg file:
+// hex digit d holds travelers 4*d thru 4*d+3, least significant bit first
+void TMGBBuilder::clinched_by(const char* code)
+{	uint32_t* w = cby.data() + cby.size() - hdr.cby_words;
+	for (size_t d = 0; code[d] && d/8 < hdr.cby_words; ++d)
+	{	uint32_t nibble = code[d] <= '9' ? code[d]-'0' : (code[d]|0x20)-'a'+10;
+		w[d/8] |= nibble << d%8*4;
+	}
+}
+
+bool TMGBBuilder::write(const std::string& filename)
+{	if (travelers.size() != hdr.num_travelers) return 0;
+	hdr.num_vertices = vertices.size();
+	hdr.num_edges    = edges.size();
+	hdr.num_points   = points.size();
+	hdr.pool_size    = pool.size();
+	hdr.vertices     = sizeof(TMGBHeader);
+	hdr.edges	 = hdr.vertices    + pad8(vertices.size()    * sizeof(TMGBVertex));
+	hdr.points       = hdr.edges       + pad8((edges.size()+1)   * sizeof(TMGBEdge));
+	hdr.clinched_by  = hdr.points      + pad8(points.size()      * sizeof(TMGBPoint));
+	hdr.travelers    = hdr.clinched_by + pad8(cby.size()	 * 4);
+	hdr.pool	 = hdr.travelers   + pad8(travelers.size()   * 4);
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) return 0;
+	const char zeros[8] = {};
+	auto section = [&](const void* data, size_t bytes)
+	{	file.write((const char*)data, bytes);
+		file.write(zeros, pad8(bytes)-bytes);
+	};
+	TMGBEdge sentinel = {0, 0, 0, uint32_t(points.size())};
+	edges.push_back(sentinel);
+	section(&hdr, sizeof(hdr));
+	section(vertices.data(),  vertices.size()  * sizeof(TMGBVertex));
+	section(edges.data(),     edges.size()     * sizeof(TMGBEdge));
+	section(points.data(),    points.size()    * sizeof(TMGBPoint));
+	section(cby.data(),       cby.size()       * 4);
+	section(travelers.data(), travelers.size() * 4);
+	section(pool.data(),      pool.size());
+	edges.pop_back();
+	return file.good();
+}
+
+// Parse a .tmg file into a new TMGBBuilder, returning an error message, or 0 on success.
+// The caller deletes the builder either way.
+const char* TMGBBuilder::read_text(std::istream& in, TMGBBuilder*& b)
+{	std::string line;
+	b = 0;
+	if (!std::getline(in, line)) return "empty file";
+	if (line.size() && line.back() == '\r') line.pop_back();
+	uint32_t format = 0;
+	while (format <= TMGB_TRAVELED && line != format_lines[format]) format++;
+	if (format > TMGB_TRAVELED) return "unsupported TMG header line";
+	unsigned long nv = 0, ne = 0, nt = 0;
+	if (!std::getline(in, line)) return "missing counts line";
+	if (sscanf(line.data(), format == TMGB_TRAVELED ? "%lu %lu %lu" : "%lu %lu", &nv, &ne, &nt)
+	    != (format == TMGB_TRAVELED ? 3 : 2)) return "invalid counts line";
+	b = new TMGBBuilder(format, nt);
+	b->vertices.reserve(nv);
+	b->edges.reserve(ne);
+	b->cby.reserve(ne*b->hdr.cby_words);
+	size_t const code_len = nt ? (nt+3)/4 : 1;
+
+	for (unsigned long v = 0; v < nv; ++v)
+	{	if (!std::getline(in, line)) return "missing vertex line";
+		char* c = strchr(&line[0], ' ');
+		if (!c) return "invalid vertex line";
+		*c = 0;
+		char* end;
+		double lat = strtod(c+1, &end);
+		double lng = strtod(end,  &c);
+		if (c == end) return "invalid vertex coordinates";
+		b->vertex(line.data(), lat, lng);
+	}
+	std::string label;
+	for (unsigned long e = 0; e < ne; ++e)
+	{	if (!std::getline(in, line)) return "missing edge line";
+		char *c, *end;
+		unsigned long v1 = strtoul(&line[0], &c, 10);
+		unsigned long v2 = strtoul(c, &end, 10);
+		if (c == line.data() || end == c || *end != ' ' || v1 >= nv || v2 >= nv)
+			return "invalid edge endpoints";
+		for (c = ++end; *end && *end != ' ' && *end != '\r'; ++end);
+		label.assign(c, end);
+		b->edge(v1, v2, label);
+		if (format == TMGB_TRAVELED)
+		{	if (*end != ' ') return "missing clinched_by code";
+			for (c = ++end; isxdigit(*end); ++end);
+			if (size_t(end-c) != code_len) return "clinched_by code length doesn't match traveler count";
+			char const next = *end;
+			*end = 0;
+			b->clinched_by(c);
+			*end = next;
+		}
+		while (*end == ' ')
+		{	double lat = strtod(end, &c);
+			double lng = strtod(c, &end);
+			if (c == end) return "invalid shaping point";
+			b->point(lat, lng);
+		}
+		if (*end && *end != '\r') return "trailing characters on edge line";
+	}
+	if (format == TMGB_TRAVELED)
+	{	if (!std::getline(in, line)) return "missing traveler names line";
+		size_t i = 0;
+		for (unsigned long t = 0; t < nt; ++t)
+		{	size_t j = line.find(' ', i);
+			if (j == std::string::npos) j = line.size();
+			if (j == i) return "fewer traveler names than traveler count";
+			b->traveler(line.substr(i, j-i));
+			i = j+1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+#ifndef TMGB_H
+#define TMGB_H
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Binary TMG ("TMGB") files hold the same graphs as .tmg files, laid out
+   so they can be mmapped & used in place with no parsing at all.
+   All values are little-endian; every section begins at a multiple of 8.
+
+     TMGBHeader
+     vertices	  num_vertices   x TMGBVertex
+     edges	  num_edges+1    x TMGBEdge; the last is a sentinel whose
+				   points field is num_points
+     points	  num_points     x TMGBPoint; shaping points of edge e are
+				   points[edges[e].points .. edges[e+1].points)
+     clinched_by  num_edges      x cby_words uint32_t; bit t set if traveler
+				   t has clinched the edge. Traveled graphs only.
+     travelers	  num_travelers  x uint32_t pool offsets of traveler names
+     pool	  pool_size bytes of NUL-terminated strings
+
+   Labels & names are stored as byte offsets into the pool.
+   Coordinates are stored as doubles & written back out with 15
+   significant digits, as siteupdate does, so text written by siteupdate
+   converts to binary & back byte for byte.
+*/
+
+struct TMGBHeader
+{	char	 magic[4];	// "TMGB"
+	uint32_t version;	// TMGB_VERSION
+	uint32_t format;	// TMGB_SIMPLE, TMGB_COLLAPSED or TMGB_TRAVELED
+	uint32_t num_vertices;
+	uint32_t num_edges;
+	uint32_t num_travelers;
+	uint32_t cby_words;	// uint32_t words per edge in clinched_by
+	uint32_t reserved;
+	uint64_t num_points;
+	uint64_t pool_size;
+	// byte offsets of sections from the beginning of the file
+	uint64_t vertices, edges, points, clinched_by, travelers, pool;
+};
+
+struct TMGBVertex
+{	double lat, lng;
+	uint32_t label;
+	uint32_t reserved;
+};
+
+struct TMGBEdge
+{	uint32_t v1, v2;
+	uint32_t label;
+	uint32_t points;	// index of 1st shaping point
+};
+
+struct TMGBPoint
+{	double lat, lng;
+};
+
+enum : uint32_t {TMGB_VERSION = 1};
+enum : uint32_t {TMGB_SIMPLE, TMGB_COLLAPSED, TMGB_TRAVELED};
+
+class TMGBFile
+{   /* Read-only view of a binary TMG file, mapped into memory.
+    open() checks the header, that all sections lie within the file,
+    and that every vertex number, pool offset & point index in them
+    is in range, so the accessors below needn't; it returns an error
+    message, or 0 on success.
+    */
+	void*  map;
+	size_t map_size;
+
+	public:
+	const TMGBHeader* header;
+	const TMGBVertex* vertices;
+	const TMGBEdge*   edges;
+	const TMGBPoint*  points;
+	const uint32_t*   cby;
+	const uint32_t*   travelers;
+	const char*	  pool;
+
+	TMGBFile();
+	TMGBFile(const TMGBFile&) = delete;
+	~TMGBFile();
+
+	const char* open(const char*);
+	void close();
+
+	const char* vertex_label(uint32_t v) const {return pool + vertices[v].label;}
+	const char* edge_label(uint32_t e)   const {return pool + edges[e].label;}
+	const char* traveler(uint32_t t)     const {return pool + travelers[t];}
+	const TMGBPoint* points_begin(uint32_t e) const {return points + edges[e].points;}
+	const TMGBPoint* points_end(uint32_t e)   const {return points + edges[e+1].points;}
+	const uint32_t* clinched_by(uint32_t e)  const {return cby + size_t(e)*header->cby_words;}
+	bool clinched(uint32_t e, uint32_t t) const {return clinched_by(e)[t/32] >> t%32 & 1;}
+
+	void write_text(std::ostream&) const;
+};
+
+class TMGBBuilder
+{   /* Accumulates a graph in memory, and writes it out as a binary TMG file.
+    Add vertices, then edges, each followed by its clinched_by code if
+    traveled & its shaping points if any, then traveler names if traveled.
+    Edge labels are interned, as most are shared by many edges.
+    */
+	TMGBHeader hdr;
+	std::vector<TMGBVertex> vertices;
+	std::vector<TMGBEdge>   edges;
+	std::vector<TMGBPoint>  points;
+	std::vector<uint32_t>   cby;
+	std::vector<uint32_t>   travelers;
+	std::string pool;
+	std::unordered_map<std::string, uint32_t> interned;
+
+	uint32_t add_string(const char*, size_t);
+
+	public:
+	TMGBBuilder(uint32_t format, uint32_t num_travelers);
+
+	void vertex(const char* label, double lat, double lng);
+	void edge(uint32_t v1, uint32_t v2, const std::string& label);
+	void clinched_by(const char* hex_code);
+	void point(double lat, double lng) {points.push_back({lat, lng});}
+	void traveler(const std::string& name) {travelers.push_back(add_string(name.data(), name.size()));}
+
+	bool write(const std::string& filename);
+	static const char* read_text(std::istream&, TMGBBuilder*&);
+};
+#endif
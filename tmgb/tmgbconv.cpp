@@ -0,0 +1,45 @@
+// Convert a .tmg file to binary TMG, or a binary TMG file back to .tmg,
+// whichever the input file is.
+#include "tmgb.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char *argv[])
+{	if (argc != 3)
+	{	std::cout << "usage: " << argv[0] << " <InputFile> <OutputFile>\n";
+		return 1;
+	}
+	std::ifstream input(argv[1], std::ios::binary);
+	if (!input.is_open())
+	{	std::cout << "Unable to open " << argv[1] << '\n';
+		return 1;
+	}
+	char magic[4] = {};
+	input.read(magic, 4);
+	if (!memcmp(magic, "TMGB", 4))
+	{	input.close();
+		TMGBFile tmgb;
+		if (const char* err = tmgb.open(argv[1]))
+		{	std::cout << argv[1] << ": " << err << '\n';
+			return 1;
+		}
+		std::ofstream output(argv[2], std::ios::binary);
+		if (!output.is_open())
+		{	std::cout << "Unable to open " << argv[2] << " for writing\n";
+			return 1;
+		}
+		tmgb.write_text(output);
+		return !output.good();
+	}
+	input.seekg(0);
+	TMGBBuilder* b;
+	const char* err = TMGBBuilder::read_text(input, b);
+	if (err)	std::cout << argv[1] << ": " << err << '\n';
+	else if (!b->write(argv[2]))
+	{	std::cout << "Unable to write " << argv[2] << '\n';
+		err = argv[2];
+	}
+	delete b;
+	return err != 0;
+}